@@ -83,11 +83,13 @@ static void s_LoadAllProjects() {
 		//current_project->Load(name);
 		current_project->SelectFile(current_project->GetSelectedFile());
 		current_project->loadedFile.Unload();
-		current_project->loadedFile.LoadFile(current_project->GetSelectedFile());
+		current_project->loadedFile.LoadFile(current_project->GetSelectedFile(), current_project->GetSnapshotPath(current_project->GetSelectedFile()), true);
+		DisplayedHeadersChanged();
 		fs::path tmpPath = fs::path(current_project->GetSelectedFile());
 		const std::string tmpstr = tmpPath.filename().string();
 		const std::string projectName = current_project->GetName();
 		current_project->loadedFile.LoadSettings("projects/" + projectName + "/" + tmpstr + ".ini");
+		current_project->LoadAllFileData();
 	}
 }
 
@@ -107,6 +109,46 @@ namespace engine {
 
 	static Image s_icon;	// Icon image that is loaded in Init()
 
+	// Frames are only drawn while something happens. After the last event a few more frames are drawn
+	// so hover effects, popups and the layout of new windows can settle
+	static constexpr double s_frameTail = 0.5;
+	static double s_lastEventTime = 0.0;
+	static bool s_wasFocused = false;
+	static uint64_t s_jobUpdates = 0;
+	static uint64_t s_watchEvents = 0;
+
+	// True if there was input, a window event or background work since the last check
+	static bool s_HasEvents() {
+		bool events = false;
+		const bool focused = IsWindowFocused();
+		if (focused != s_wasFocused || IsWindowResized() || IsFileDropped())
+			events = true;
+		s_wasFocused = focused;
+		// Jobs and watchers run on other threads, they only count their updates
+		const uint64_t jobUpdates = jobs::GetUpdateCount();
+		const uint64_t watchEvents = watcher::GetEventCount();
+		if (jobUpdates != s_jobUpdates || watchEvents != s_watchEvents)
+			events = true;
+		s_jobUpdates = jobUpdates;
+		s_watchEvents = watchEvents;
+		if (events)
+			return true;
+		const Vector2 mouseDelta = GetMouseDelta();
+		const Vector2 wheel = GetMouseWheelMoveV();
+		if (mouseDelta.x != 0.0f || mouseDelta.y != 0.0f || wheel.x != 0.0f || wheel.y != 0.0f)
+			return true;
+		for (int button = MOUSE_BUTTON_LEFT; button <= MOUSE_BUTTON_BACK; button++) {
+			if (IsMouseButtonDown(button) || IsMouseButtonReleased(button))
+				return true;
+		}
+		// Key states are checked instead of the key queue, so no key gets taken away from ImGui
+		for (int key = KEY_SPACE; key <= KEY_KB_MENU; key++) {
+			if (IsKeyDown(key) || IsKeyReleased(key))
+				return true;
+		}
+		return false;
+	}
+
 	ENGINE_ERROR GetErrorcode() {
 		return errorcode;
 	}
@@ -227,9 +269,16 @@ namespace engine {
 
 	void Render() {
 		// Skip drawing if the window is not even focused (cpu usage=0%)
-		// Maybe add input detection aswell to only update when mouse movement
-		// or key presses happened
 		if (!IsWindowFocused()) {
+			s_wasFocused = false;
+			PollInputEvents();
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			return;
+		}
+		// Focused windows only draw after events, so an idle window does not use the cpu either
+		if (s_HasEvents())
+			s_lastEventTime = GetTime();
+		if (GetTime() - s_lastEventTime > s_frameTail) {
 			PollInputEvents();
 			std::this_thread::sleep_for(std::chrono::milliseconds(10));
 			return;
@@ -365,6 +414,13 @@ namespace ui {
 		std::string header = "";
 	} filterSettings;
 	static std::vector<std::pair<int, RowInfo>> s_filteredData;
+	static std::string s_editedHeader;	// Header and value DisplayData reported as edited
+	static std::string s_editedValue;
+	static std::string s_sortHeader = "";	// Header the dataview is sorted by, empty for file order
+	static bool s_sortDescending = false;
+	static std::vector<std::string> s_groupHeaders;	// Headers to group by for the aggregation
+	static std::vector<std::string> s_valueHeaders;	// Headers to sum up for the aggregation
+	static FileInfo s_groupResult;
 	bool s_deleteEmptyLines = true;
 	int s_rowDataPositionToAdd = 0;
 
@@ -470,6 +526,9 @@ namespace ui {
 	}
 
 	void Shutdown() {
+		// Let saves that are still running finish
+		jobs::Shutdown();
+		watcher::Shutdown();
 		// Save all projects loaded
 		for (auto& project : projects) {
 			project.Save();
@@ -488,6 +547,80 @@ namespace ui {
 		}
 	}
 
+	// Splits or exports every xlsx inside path on the workers. The output indices are assigned before
+	// any file runs, so the files can be processed in parallel without listing outpath again
+	static void s_SplitFolder(const std::string& path, const std::string& outpath, const std::vector<std::string>& sheetnames, const bool exportOnly) {
+		jobs::Submit("Ordner: " + path, [=](jobs::JobStatus& status) {
+			std::vector<std::string> files;
+			for (const auto& dirEntry : fs::directory_iterator(path)) {
+				std::string filepath = dirEntry.path().string();
+				ReplaceAllSubstrings(filepath, "\\", "/");
+				if (!StrEndswith(filepath, ".xlsx"))
+					continue;
+				files.push_back(filepath);
+			}
+			size_t count = std::distance(fs::directory_iterator(outpath), fs::directory_iterator{});
+			for (size_t x = 0; x < files.size(); x++) {
+				const std::string filepath = files[x];
+				const int startindex = static_cast<int>(count);
+				for (const auto& name : GetWorksheetNames(filepath)) {
+					if (!exportOnly || std::find(sheetnames.begin(), sheetnames.end(), name) != sheetnames.end())
+						count++;
+				}
+				jobs::Submit(fs::path(filepath).filename().string(), [=](jobs::JobStatus&) {
+					if (exportOnly)
+						return ExportWorksheets(filepath, sheetnames, outpath, startindex);
+					return SplitWorksheets(filepath, outpath, startindex);
+				});
+				status.SetProgress(static_cast<float>(x + 1) / static_cast<float>(files.size()));
+			}
+			status.SetStatusText(std::to_string(files.size()) + " Dateien");
+			return true;
+		});
+	}
+
+	// Shows all jobs running in the background with their progress and errors
+	static void JobsWindow() {
+		const auto jobList = jobs::GetJobs();
+		if (jobList.empty())
+			return;
+		ImGui::SetNextWindowSize({ 400.0f, 250.0f }, ImGuiCond_FirstUseEver);
+		ImGui::Begin("Aufgaben");
+		size_t finished = 0;
+		for (const auto& job : jobList) {
+			if (job->IsFinished())
+				finished++;
+		}
+		ImGui::Text("%d von %d fertig", static_cast<int>(finished), static_cast<int>(jobList.size()));
+		ImGui::SameLine();
+		if (ImGui::Button("Erledigte entfernen"))
+			jobs::ClearFinishedJobs();
+		ImGui::Separator();
+		for (const auto& job : jobList) {
+			ImGui::PushID(job.get());
+			const std::string name = job->GetName();
+			switch (job->GetState()) {
+			case jobs::JOB_PENDING:
+				ImGui::Text("%s: Wartet", name.c_str());
+				break;
+			case jobs::JOB_RUNNING:
+				ImGui::ProgressBar(job->GetProgress(), { 100.0f, 0.0f });
+				ImGui::SameLine();
+				ImGui::Text("%s", name.c_str());
+				break;
+			case jobs::JOB_DONE:
+				ImGui::Text("%s: Fertig %s", name.c_str(), job->GetStatusText().c_str());
+				break;
+			case jobs::JOB_FAILED:
+				ImGui::Text("%s: Fehlgeschlagen %s", name.c_str(), job->GetStatusText().c_str());
+				ImGui::SetItemTooltip("Details stehen im Log");
+				break;
+			}
+			ImGui::PopID();
+		}
+		ImGui::End();
+	}
+
 	static void MainMenu() {
 		ImGui::BeginMainMenuBar();
 		// Arbeitsfenster wechseln
@@ -509,7 +642,9 @@ namespace ui {
 						outputFolder = "sheets/";
 					else
 						outputFolder += "/";
-					SplitWorksheets(filename, outputFolder);
+					jobs::Submit(fs::path(filename).filename().string(), [=](jobs::JobStatus&) {
+						return SplitWorksheets(filename, outputFolder);
+					});
 				}
 			}
 			ImGui::SetItemTooltip("Konvertiert alle Tabellen zu einzelnen xlsx Dateien");
@@ -517,14 +652,7 @@ namespace ui {
 				const std::string path = OpenDirectoryDialog();
 				const std::string outpath = OpenDirectoryDialog() + "/";
 				if (path != "" && outpath != "") {
-					for (const auto& dirEntry : fs::directory_iterator(path)) {
-						std::string filepath = dirEntry.path().string();
-						ReplaceAllSubstrings(filepath, "\\", "/");
-						if (!StrEndswith(filepath, ".xlsx"))
-							continue;
-						size_t count = std::distance(fs::directory_iterator(outpath), fs::directory_iterator{});
-						SplitWorksheets(filepath, outpath, count);
-					}
+					s_SplitFolder(path, outpath, {}, false);
 				}
 			}
 			ImGui::SetItemTooltip((char*)u8"Splittet alle Tabellen in gewhlten Ordner in einzelne Tabellen\nund speichert sie in gewhltem Ausgabeordner");
@@ -547,28 +675,28 @@ namespace ui {
 				const std::string file = OpenFileDialog("Excel sheets", "xlsx,XLSX");
 				const std::string outpath = OpenDirectoryDialog() + "/";
 				if (file != "") {
-					ExportWorksheets(file, exportstrings, outpath);
+					const std::vector<std::string> sheetnames = exportstrings;
+					jobs::Submit(fs::path(file).filename().string(), [=](jobs::JobStatus&) {
+						return ExportWorksheets(file, sheetnames, outpath);
+					});
 				}
 			}
 			if (exportstrings.size() > 0 && ImGui::Button("Export All Worksheets in folder")) {
 				const std::string path = OpenDirectoryDialog();
 				const std::string outpath = OpenDirectoryDialog() + "/";
 				if (path != "" && outpath != "") {
-					for (const auto& dirEntry : fs::directory_iterator(path)) {
-						std::string filepath = dirEntry.path().string();
-						ReplaceAllSubstrings(filepath, "\\", "/");
-						if (!StrEndswith(filepath, ".xlsx"))
-							continue;
-						size_t count = std::distance(fs::directory_iterator(outpath), fs::directory_iterator{});
-						ExportWorksheets(filepath, exportstrings, outpath, count);
-					}
+					s_SplitFolder(path, outpath, exportstrings, true);
 				}
 			}
 			ImGui::SeparatorText("File Editor");
 			if (ImGui::Button("Edit Worksheet")) {
 				const std::string filename = OpenFileDialog("Excel Sheet", "xlsx,csv");
 				if (filename != "") {
-					EditWorksheet(filename, s_rowDataPositionToAdd, s_deleteEmptyLines);
+					const int dataRow = s_rowDataPositionToAdd;
+					const bool deleteEmpty = s_deleteEmptyLines;
+					jobs::Submit(fs::path(filename).filename().string(), [=](jobs::JobStatus&) {
+						return EditWorksheet(filename, dataRow, deleteEmpty);
+					});
 				}
 			}
 			if (ImGui::Button("Edit Folder")) {
@@ -583,7 +711,11 @@ namespace ui {
 
 							// Process only xlsx files starting with "sheet_"
 							if (StrEndswith(fname, ".xlsx") || StrEndswith(fname, ".csv")) {
-								EditWorksheet(fname, s_rowDataPositionToAdd, s_deleteEmptyLines);
+								const int dataRow = s_rowDataPositionToAdd;
+								const bool deleteEmpty = s_deleteEmptyLines;
+								jobs::Submit(entry.path().filename().string(), [=](jobs::JobStatus&) {
+									return EditWorksheet(fname, dataRow, deleteEmpty);
+								});
 							}
 						}
 					}
@@ -651,12 +783,12 @@ namespace ui {
 									(char*)u8" Dateigre: " + std::to_string(filesize) + " Bytes";
 								ImGui::PushID(&buttonStr);
 								if (ImGui::Button(buttonStr.data())) {
-									const std::string originalPath = fs::u8path(current_project->loadedFile.GetFilename()).parent_path().string() + "/";
-									fs::copy_file(filepath + backupFilename, originalPath + filename, fs::copy_options::overwrite_existing);
+									RestoreBackup(entry.path(), fs::u8path(current_project->loadedFile.GetFilename()));
 									const std::string file = current_project->GetSelectedFile();
 									current_project->SelectFile(file);
 									current_project->loadedFile.Unload();
-									current_project->loadedFile.LoadFile(file);
+									current_project->loadedFile.LoadFile(file, current_project->GetSnapshotPath(file), true);
+									DisplayedHeadersChanged();
 									fs::path tmpPath = fs::path(file);
 									const std::string tmpstr = tmpPath.filename().string();
 									const std::string projectName = current_project->GetName();
@@ -750,13 +882,17 @@ namespace ui {
 					if (!current_project->loadedFile.IsReady()) {
 						current_project->SelectFile(current_project->GetSelectedFile());
 						current_project->loadedFile.Unload();
-						current_project->loadedFile.LoadFile(current_project->GetSelectedFile());
+						current_project->loadedFile.LoadFile(current_project->GetSelectedFile(), current_project->GetSnapshotPath(current_project->GetSelectedFile()), true);
+						DisplayedHeadersChanged();
 						fs::path tmpPath = fs::path(current_project->GetSelectedFile());
 						const std::string tmpstr = tmpPath.filename().string();
 						const std::string projectName = current_project->GetName();
 						current_project->loadedFile.LoadSettings("projects/" + projectName + "/" + tmpstr + ".ini");
 					}
+					current_project->LoadAllFileData();
 					s_hiddenHeaders.clear();
+					s_sortHeader = "";
+					CancelDataTableEdit();
 				}
 				if (selected)
 					ImGui::SetItemDefaultFocus();
@@ -792,12 +928,15 @@ namespace ui {
 					current_project->Save();
 					current_project->SelectFile(file);
 					current_project->loadedFile.Unload();
-					current_project->loadedFile.LoadFile(file);
+					current_project->loadedFile.LoadFile(file, current_project->GetSnapshotPath(file), true);
+					DisplayedHeadersChanged();
 					fs::path tmpPath = fs::path(file);
 					const std::string tmpstr = tmpPath.filename().string();
 					const std::string projectName = current_project->GetName();
 					current_project->loadedFile.LoadSettings("projects/" + projectName + "/" + tmpstr + ".ini");
 					s_hiddenHeaders.clear();
+					s_sortHeader = "";
+					CancelDataTableEdit();
 					s_ignoreCache = false;
 				}
 				if (selected)
@@ -808,7 +947,9 @@ namespace ui {
 		}
 		// Handle adding new files
 		if (rlImGuiImageButtonSize((char*)u8"Neue Datei Hinzufgen", &file_icon, { 30.0f, 30.0f })) {
-			current_project->AddFilePath(OpenFileDialog("Excel Sheet", "xlsx,csv"));
+			const std::string file = OpenFileDialog("Excel Sheet", "xlsx,csv");
+			current_project->AddFilePath(file);
+			current_project->LoadFileData(file);
 		}
 		ImGui::SetItemTooltip((char*)u8"Datei hinzufgen");
 		ImGui::SameLine();
@@ -835,8 +976,7 @@ namespace ui {
 		if (rlImGuiImageButtonSize("Datei speichern", &save_icon, { 30.0f, 30.0f })) {
 			if (current_project->loadedFile.IsReady()) {
 				const std::string filename = current_project->loadedFile.GetFilename();
-				BackupFile(filename);
-				current_project->loadedFile.SaveFileAs(filename, filename);
+				current_project->loadedFile.SaveFileAs(filename, filename, true);
 			}
 		}
 		ImGui::SetItemTooltip((char*)u8"Datei speichern (berschreibt geladene Datei)");
@@ -846,6 +986,25 @@ namespace ui {
 			s_ignoreCache = false;
 		}
 		ImGui::SetItemTooltip((char*)u8"Merged alle Daten fr gewhlte Datei");
+		// Saving runs in the background, so only its state is shown here
+		auto saveStatus = current_project->loadedFile.GetSaveStatus();
+		if (saveStatus) {
+			ImGui::SameLine();
+			switch (saveStatus->GetState()) {
+			case jobs::JOB_PENDING:
+			case jobs::JOB_RUNNING:
+				ImGui::ProgressBar(saveStatus->GetProgress(), { 150.0f, 0.0f }, saveStatus->GetStatusText().c_str());
+				break;
+			case jobs::JOB_DONE:
+				ImGui::Text("Gespeichert");
+				break;
+			case jobs::JOB_FAILED:
+				ImGui::Text("Speichern fehlgeschlagen!");
+				// The log is written by every job, only the status belongs to this save
+				ImGui::SetItemTooltip("%s", saveStatus->GetStatusText().c_str());
+				break;
+			}
+		}
 	}
 
 	static void DisplayFileSettings() {
@@ -861,6 +1020,7 @@ namespace ui {
 		ImGui::SameLine();
 		ImGui::Text("Aktueller Merge-Ordner: %s", mergefolderpath.string().c_str());
 		if (current_project->loadedFile.Settings->IsMergeFolderSet()) {
+			current_project->loadedFile.Settings->UpdateMergeFolder();
 			if (rlImGuiImageButtonSize((char*)u8"Whle template", &file_icon, {30.0f, 30.0f})) {
 				std::string templatefile = OpenFileDialog("Excel Sheet", "xlsx,csv");
 				if (templatefile != "") {
@@ -902,7 +1062,7 @@ namespace ui {
 				FileInfo mergefile;
 				mergefile.LoadFile(filename);
 				if (mergefile.IsReady()) {
-					current_project->loadedFile.Settings->SetMergeFile(mergefile);
+					current_project->loadedFile.Settings->SetMergeFile(std::move(mergefile));
 				}
 			}
 		}
@@ -920,8 +1080,8 @@ namespace ui {
 		*/
 	
 		// Retrieve data for displaying settings
-		auto headers = current_project->loadedFile.GetHeaderNames();
-		auto mergeheaders = current_project->loadedFile.Settings->GetMergeFile().GetHeaderNames();
+		const auto& headers = current_project->loadedFile.GetHeaderNames();
+		const auto& mergeheaders = current_project->loadedFile.Settings->GetMergeFile().GetHeaderNames();
 		auto setmergeheaders = current_project->loadedFile.Settings->GetMergeHeaders();
 		auto headerif = current_project->loadedFile.Settings->GetMergeIf();
 
@@ -1004,14 +1164,15 @@ namespace ui {
 						s_hiddenHeaders.erase(it);
 					}
 				}
+				DisplayedHeadersChanged();
 			}
 		}
 	}
 
 	static void DisplayHeaderMergeFolderSettings() {
 		// Retrieve data
-		auto headers = current_project->loadedFile.GetHeaderNames();
-		auto mergeheaders = current_project->loadedFile.Settings->GetMergeFolderTemplate().GetHeaderNames();
+		const auto& headers = current_project->loadedFile.GetHeaderNames();
+		const auto& mergeheaders = current_project->loadedFile.Settings->GetMergeFolderTemplate().GetHeaderNames();
 		auto setmergeheaders = current_project->loadedFile.Settings->GetMergeFolderHeaders();
 		auto headerif = current_project->loadedFile.Settings->GetMergeFolderIf();
 		std::string dontimportif = current_project->loadedFile.Settings->GetDontImportIf();
@@ -1181,17 +1342,30 @@ namespace ui {
 	}
 
 	void FilterData() {
-		std::vector<RowInfo>&& data = current_project->loadedFile.GetData();
+		const std::vector<RowInfo>& data = current_project->loadedFile.GetData();
 		s_filteredData.clear();
+		CancelDataTableEdit();
 		// Filter for searchbar
 		if (s_filter != "") {
-			const std::vector<std::string> headernames = current_project->loadedFile.GetHeaderNames();
+			const std::vector<std::string>& headernames = current_project->loadedFile.GetHeaderNames();
+			// Encoded columns only get every distinct value checked once
+			std::vector<const ColumnDictionary*> dictionaries;
+			std::vector<std::vector<bool>> matches;
+			for (const std::string& header : headernames) {
+				const ColumnDictionary* dictionary = current_project->loadedFile.GetDictionary(header);
+				std::vector<bool> match;
+				for (uint32_t code = 0; dictionary && code < dictionary->Size(); code++) {
+					match.push_back(StrContains(dictionary->GetValue(code), s_filter));
+				}
+				dictionaries.push_back(dictionary);
+				matches.push_back(std::move(match));
+			}
 			for (int x = 0; x < data.size(); x++) {
-				RowInfo& row = data[x];
+				const RowInfo& row = data[x];
 				bool hasFilter = false;
-				for (const std::string& header : headernames) {
-					const std::string value = row.GetData(header);
-					if (StrContains(value, s_filter)) {
+				for (size_t h = 0; h < headernames.size(); h++) {
+					const uint32_t code = row.GetCode(headernames[h], dictionaries[h]);
+					if (code != ColumnDictionary::NO_CODE ? matches[h][code] : StrContains(row.GetData(headernames[h]), s_filter)) {
 						hasFilter = true;
 						break;
 					}
@@ -1204,127 +1378,77 @@ namespace ui {
 		// Filter by mathematic modes
 		switch (s_filtermode) {
 		case FILTER_MIN:
-			float value_min;
+		case FILTER_MAX: {
+			// The column statistics already know the extreme value, so only the matching rows are collected
 			s_filteredData.clear();
+			const ColumnStats& stats = current_project->loadedFile.GetColumnStats(filterSettings.header);
+			if (stats.numericCount == 0)
+				break;
+			const double target = (s_filtermode == FILTER_MIN) ? stats.min : stats.max;
 			for (int x = 0; x < data.size(); x++) {
-				RowInfo& rinfo = data[x];
-				std::string value = rinfo.GetData(filterSettings.header);
-				if (value == "")
-					continue;
-				if (!IsNumber(value) && !IsInteger(value))
-					continue;
-				ReplaceAllSubstrings(value, ",", ".");
-				float value_number = std::stof(value);
-				if (x == 0) {
-					value_min = value_number;
-					s_filteredData.push_back(std::make_pair(x, rinfo));
-					continue;
-				}
-				if (value_min > value_number) {
-					s_filteredData.clear();
-					value_min = value_number;
-					s_filteredData.push_back(std::make_pair(x, rinfo));
-				}
-				else if (value_min == value_number) {
-					s_filteredData.push_back(std::make_pair(x, rinfo));
-				}
-			}
-			break;
-		case FILTER_MAX:
-			float value_max;
-			for (int x = 0; x < data.size(); x++) {
-				RowInfo& rinfo = data[x];
-				std::string value = rinfo.GetData(filterSettings.header);
-				if (value == "")
-					continue;
-				if (!IsNumber(value) && !IsInteger(value))
-					continue;
-				ReplaceAllSubstrings(value, ",", ".");
-				float value_number = std::stof(value);
-				if (x == 0) {
-					value_max = value_number;
+				const RowInfo& rinfo = data[x];
+				double value_number;
+				if (rinfo.GetNumber(filterSettings.header, value_number) && value_number == target)
 					s_filteredData.push_back(std::make_pair(x, rinfo));
-					continue;
-				}
-				if (value_max < value_number) {
-					s_filteredData.clear();
-					value_max = value_number;
-					s_filteredData.push_back(std::make_pair(x, rinfo));
-				}
-				else if (value_max == value_number) {
-					s_filteredData.push_back(std::make_pair(x, rinfo));
-				}
 			}
 			break;
+		}
 		case FILTER_GREATER_THAN:
 			for (int x = 0; x < data.size(); x++) {
-				RowInfo& rinfo = data[x];
-				std::string value = rinfo.GetData(filterSettings.header);
-				if (value == "")
+				const RowInfo& rinfo = data[x];
+				// Numbers were typed while loading, so nothing is parsed here
+				double value_number;
+				if (!rinfo.GetNumber(filterSettings.header, value_number))
 					continue;
-				else if (!IsNumber(value) && !IsInteger(value))
-					continue;
-				ReplaceAllSubstrings(value, ",", ".");
-				float value_number = std::stof(value);
 				if (value_number > filterSettings.max)
 					s_filteredData.push_back(std::make_pair(x, rinfo));
 			}
 			break;
 		case FILTER_LOWER_THAN:
 			for (int x = 0; x < data.size(); x++) {
-				RowInfo& rinfo = data[x];
-				std::string value = rinfo.GetData(filterSettings.header);
-				if (value == "")
-					continue;
-				else if (!IsNumber(value) && !IsInteger(value))
+				const RowInfo& rinfo = data[x];
+				double value_number;
+				if (!rinfo.GetNumber(filterSettings.header, value_number))
 					continue;
-				ReplaceAllSubstrings(value, ",", ".");
-				float value_number = std::stof(value);
 				if (value_number < filterSettings.min)
 					s_filteredData.push_back(std::make_pair(x, rinfo));
 			}
 			break;
 		case FILTER_OUT_OF_RANGE:
 			for (int x = 0; x < data.size(); x++) {
-				RowInfo& rinfo = data[x];
-				std::string value = rinfo.GetData(filterSettings.header);
-				if (value == "")
+				const RowInfo& rinfo = data[x];
+				double value_number;
+				if (!rinfo.GetNumber(filterSettings.header, value_number))
 					continue;
-				else if (!IsNumber(value) && !IsInteger(value))
-					continue;
-				ReplaceAllSubstrings(value, ",", ".");
-				float value_number = std::stof(value);
 				if (value_number < filterSettings.min || value_number > filterSettings.max)
 					s_filteredData.push_back(std::make_pair(x, rinfo));
 			}
 			break;
 		case FILTER_IN_RANGE:
 			for (int x = 0; x < data.size(); x++) {
-				RowInfo& rinfo = data[x];
-				std::string value = rinfo.GetData(filterSettings.header);
-				if (value == "")
-					continue;
-				else if (!IsNumber(value) && !IsInteger(value))
+				const RowInfo& rinfo = data[x];
+				double value_number;
+				if (!rinfo.GetNumber(filterSettings.header, value_number))
 					continue;
-				ReplaceAllSubstrings(value, ",", ".");
-				float value_number = std::stof(value);
 				if (value_number > filterSettings.min && value_number < filterSettings.max)
 					s_filteredData.push_back(std::make_pair(x, rinfo));
 			}
 			break;
 		case FILTER_EMPTY:
+			if (current_project->loadedFile.GetColumnStats(filterSettings.header).emptyCount == 0)
+				break;
 			for (int x = 0; x < data.size(); x++) {
-				RowInfo& rinfo = data[x];
-				const std::string value = rinfo.GetData(filterSettings.header);
-				if (value == "")
+				const RowInfo& rinfo = data[x];
+				const Cell* cell = rinfo.GetCell(filterSettings.header);
+				if (!cell || cell->type == CELL_EMPTY)
 					s_filteredData.push_back(std::make_pair(x, rinfo));
 			}
 			break;
 		case FILTER_NOT_EMPTY:
 			for (int x = 0; x < data.size(); x++) {
-				RowInfo& rinfo = data[x];
-				const std::string value = rinfo.GetData(filterSettings.header);
-				if (value != "")
+				const RowInfo& rinfo = data[x];
+				const Cell* cell = rinfo.GetCell(filterSettings.header);
+				if (cell && cell->type != CELL_EMPTY)
 					s_filteredData.push_back(std::make_pair(x, rinfo));
 			}
 			break;
@@ -1332,6 +1456,52 @@ namespace ui {
 		default:
 			break;
 		}
+		// Keep the filtered rows in the order of the current sorting
+		if (s_sortHeader != "" && s_filteredData.size() > 1) {
+			const std::vector<int>& order = current_project->loadedFile.GetSortedIndex(s_sortHeader, !s_sortDescending);
+			std::vector<int> rank(order.size());
+			for (int x = 0; x < order.size(); x++) {
+				rank[order[x]] = x;
+			}
+			std::stable_sort(s_filteredData.begin(), s_filteredData.end(),
+				[&rank](const std::pair<int, RowInfo>& a, const std::pair<int, RowInfo>& b) {
+					return rank[a.first] < rank[b.first];
+				});
+		}
+	}
+
+	// Result of the last aggregation is shown in its own window until it gets closed
+	static void GroupResultWindow() {
+		if (!s_groupResult.IsReady())
+			return;
+		float screenW = static_cast<float>(GetScreenWidth());
+		float screenH = static_cast<float>(GetScreenHeight());
+		ImGui::SetNextWindowSize({ screenW * 0.6f, screenH * 0.5f }, ImGuiCond_FirstUseEver);
+		bool open = true;
+		ImGui::Begin("Gruppierung", &open, ImGuiWindowFlags_HorizontalScrollbar);
+		if (ImGui::Button("Ergebnis speichern")) {
+			const std::string filename = OpenFileDialog("Excel Sheet", "xlsx,csv");
+			if (filename != "")
+				s_groupResult.SaveFile(filename);
+		}
+		const std::vector<RowInfo>& groupData = s_groupResult.GetData();
+		ImGui::SameLine();
+		ImGui::Text("Gruppen: %d", static_cast<int>(groupData.size()));
+		// Only the visible groups get copied and drawn, there can be as many as there are rows
+		ImGuiListClipper clipper;
+		clipper.Begin(static_cast<int>(groupData.size()));
+		while (clipper.Step()) {
+			for (int x = clipper.DisplayStart; x < clipper.DisplayEnd; x++) {
+				if (x >= groupData.size())
+					break;
+				if (DisplayData(groupData[x], x, s_editedHeader, s_editedValue, "horizontal-aboveheader"))
+					s_groupResult.UpdateValue(x, s_editedHeader, s_editedValue);
+			}
+		}
+		clipper.End();
+		ImGui::End();
+		if (!open)
+			s_groupResult.Unload();
 	}
 
 	void DataViewWindow() {
@@ -1340,7 +1510,7 @@ namespace ui {
 			return;
 		}
 		// Collecting the dataset
-		std::vector<RowInfo>&& data = current_project->loadedFile.GetData();
+		const std::vector<RowInfo>& data = current_project->loadedFile.GetData();
 		auto&& headers = current_project->loadedFile.GetHeaderNames();
 		// Setting up window flaghs and settings
 		int flags = ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_MenuBar | ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_HorizontalScrollbar;
@@ -1366,6 +1536,9 @@ namespace ui {
 			if (ImGui::Button("Vertikal L")) {
 				s_viewmode = "vertical-leftheader";
 			}
+			if (ImGui::Button("Tabelle")) {
+				s_viewmode = "table";
+			}
 			ImGui::EndMenu();
 		}
 		// Dropdwon to select which headers not to display
@@ -1383,12 +1556,72 @@ namespace ui {
 		}
 		if (ImGui::Button((char*)u8"Datenstze lschen")) {
 			current_project->loadedFile.ClearData();
+			CancelDataTableEdit();
+		}
+		if (ImGui::BeginMenu("Sortieren")) {
+			const std::string sortlabel = (s_sortHeader == "") ? "NONE" : Splitlines(s_sortHeader, " ##").first;
+			if (ImGui::BeginCombo("Sortieren nach", sortlabel.c_str())) {
+				bool selected = (s_sortHeader == "");
+				if (ImGui::Selectable("NONE", &selected)) {
+					s_sortHeader = "";
+					FilterData();
+				}
+				for (auto&& header : headers) {
+					if (Splitlines(header, " ##").first == "")
+						continue;
+					selected = (header == s_sortHeader);
+					if (ImGui::Selectable(header.c_str(), &selected)) {
+						s_sortHeader = header;
+						FilterData();
+					}
+					if (selected)
+						ImGui::SetItemDefaultFocus();
+				}
+				ImGui::EndCombo();
+			}
+			if (ImGui::Checkbox("Absteigend", &s_sortDescending)) {
+				FilterData();
+			}
+			ImGui::EndMenu();
+		}
+		if (ImGui::BeginMenu("Gruppieren")) {
+			// Each header can either be grouped by or be summed up per group
+			ImGui::SeparatorText("Gruppieren nach / Summieren");
+			for (auto&& header : headers) {
+				const std::string splitheader = Splitlines(header, " ##").first;
+				if (splitheader == "")
+					continue;
+				ImGui::PushID(header.c_str());
+				auto groupIt = std::find(s_groupHeaders.begin(), s_groupHeaders.end(), header);
+				bool group = (groupIt != s_groupHeaders.end());
+				if (ImGui::Checkbox("## group", &group)) {
+					if (group)
+						s_groupHeaders.push_back(header);
+					else
+						s_groupHeaders.erase(groupIt);
+				}
+				ImGui::SameLine();
+				auto valueIt = std::find(s_valueHeaders.begin(), s_valueHeaders.end(), header);
+				bool value = (valueIt != s_valueHeaders.end());
+				if (ImGui::Checkbox(splitheader.c_str(), &value)) {
+					if (value)
+						s_valueHeaders.push_back(header);
+					else
+						s_valueHeaders.erase(valueIt);
+				}
+				ImGui::PopID();
+			}
+			if (s_groupHeaders.size() > 0 && ImGui::Button("Gruppierung berechnen")) {
+				current_project->loadedFile.Aggregate(s_groupHeaders, s_valueHeaders, s_groupResult);
+			}
+			ImGui::EndMenu();
 		}
 		if (ImGui::BeginMenu("Filteroptionen")) {
 			// Reset filters
 			if (ImGui::Button((char*)u8"Filter zurcksetzen")) {
 				s_filter = "";
 				s_filteredData.clear();
+				CancelDataTableEdit();
 				filterSettings.header = "";
 				filterSettings.max = 0.0f;
 				filterSettings.min = 0.0f;
@@ -1443,6 +1676,13 @@ namespace ui {
 				}
 				ImGui::EndCombo();
 			}
+			// Show the cached statistics of the selected header
+			if (filterSettings.header != "" && filterSettings.header != "NONE") {
+				const ColumnStats& stats = current_project->loadedFile.GetColumnStats(filterSettings.header);
+				ImGui::Text("Werte: %zu  Leer: %zu  Eindeutig: ~%zu", stats.rows - stats.emptyCount, stats.emptyCount, stats.distinctEstimate);
+				if (stats.numericCount > 0)
+					ImGui::Text("Min: %.3f  Max: %.3f  Summe: %.3f", stats.min, stats.max, stats.sum);
+			}
 			// Now apply the different filter methods (create different functions for it?)
 			// Definetly needs a refactor i think but its working fine rn
 			switch (s_filtermode) {
@@ -1502,30 +1742,73 @@ namespace ui {
 			}
 			ImGui::EndChild();
 		}
+		// The table only draws the cells on screen, rows are looked up the same way as below
+		if (s_viewmode == "table") {
+			ImGui::SeparatorText(sets.c_str());
+			const bool filtered = s_filteredData.size() != 0 || s_filter != "";
+			const std::vector<int>* order = nullptr;
+			if (!filtered && s_sortHeader != "")
+				order = &current_project->loadedFile.GetSortedIndex(s_sortHeader, !s_sortDescending);
+			auto rowIndex = [&](const int i) {
+				if (filtered)
+					return s_filteredData[i].first;
+				return order && i < order->size() ? (*order)[i] : i;
+			};
+			DisplayDataTable(headers, static_cast<int>(filtered ? s_filteredData.size() : data.size()),
+				[&](const int i) -> const RowInfo& {
+					return filtered ? s_filteredData[i].second : data[rowIndex(i)];
+				},
+				rowIndex,
+				[&](const int i, const RowInfo& row) {
+					if (filtered)
+						s_filteredData[i].second = row;
+					current_project->loadedFile.SetRowData(row, rowIndex(i));
+				},
+				[&](const int i) {
+					current_project->loadedFile.RemoveData(rowIndex(i));
+					if (filtered)
+						FilterData();
+				},
+				s_hiddenHeaders);
+			ImGui::End();
+			GroupResultWindow();
+			return;
+		}
 		ImGui::Separator();
 		ImGui::BeginChild("dataview", {(DEFAULT_INPUT_WIDTH + 10.0f) * (headers.size() - s_hiddenHeaders.size()) + 50.0f, screenH - 155.0f}, 0, flags_nomenu);
 		// Now drawing the filtered data if there is any
 		if (s_filteredData.size() == 0 && s_filter == "") {
+			// Sorting only reorders the row indexes, the data itself stays as it is
+			const std::vector<int>* order = nullptr;
+			if (s_sortHeader != "")
+				order = &current_project->loadedFile.GetSortedIndex(s_sortHeader, !s_sortDescending);
 			ImGuiListClipper clipper;
 			clipper.Begin(data.size());
 			while (clipper.Step()) {
-				for (int x = clipper.DisplayStart; x < clipper.DisplayEnd; ++x) {
-					RowInfo& row = data[x];
+				for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+					if (order && i >= order->size())
+						break;
+					const int x = order ? (*order)[i] : i;
+					if (x >= data.size())
+						break;	// A row got removed during this frame
 
 					ImGui::SetNextItemWidth(6.0f);
-					if (ImGui::Button((" X ##" + std::to_string(x)).c_str())) {
+					ImGui::PushID(x);
+					if (ImGui::Button(" X ")) {
 						current_project->loadedFile.RemoveData(x);
 					}
 					ImGui::SetItemTooltip((char*)u8"Lscht diesen kompletten Eintrag!");
+					ImGui::PopID();
 
 					if (StrContains(s_viewmode, "horizontal"))
 						ImGui::SameLine();
 
-					DisplayData(row, x, s_viewmode, s_hiddenHeaders);
-
-					if (row.Changed()) {
-						current_project->loadedFile.SetRowData(row, x);
-					}
+					// The row is gone if its delete button was just pressed
+					if (x >= data.size())
+						break;
+					// Only the edited value is written back, the row is never copied for drawing
+					if (DisplayData(data[x], x, s_editedHeader, s_editedValue, s_viewmode, s_hiddenHeaders))
+						current_project->loadedFile.UpdateValue(x, s_editedHeader, s_editedValue);
 				}
 			}
 			clipper.End();  // Optional: usually not required, but explicit is good
@@ -1537,24 +1820,32 @@ namespace ui {
 
 			while (clipper.Step()) {
 				for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+					if (i >= s_filteredData.size())
+						break;	// A row got removed during this frame
 					auto it = std::next(s_filteredData.begin(), i);
 					int id = it->first;
 					RowInfo& row = it->second;
 
 					ImGui::SetNextItemWidth(6.0f);
-					if (ImGui::Button((" X ##" + std::to_string(id)).c_str())) {
+					ImGui::PushID(id);
+					bool removed = false;
+					if (ImGui::Button(" X ")) {
 						current_project->loadedFile.RemoveData(id);
 						FilterData();
+						removed = true;
 					}
 					ImGui::SetItemTooltip((char*)u8"Lscht diesen kompletten Eintrag!");
+					ImGui::PopID();
+					// Filtering again replaced the rows, row does not point to one anymore
+					if (removed)
+						break;
 
 					if (StrContains(s_viewmode, "horizontal"))
 						ImGui::SameLine();
 
-					DisplayData(row, id, s_viewmode, s_hiddenHeaders);
-
-					if (row.Changed()) {
-						current_project->loadedFile.SetRowData(row, id);
+					if (DisplayData(row, id, s_editedHeader, s_editedValue, s_viewmode, s_hiddenHeaders)) {
+						row.UpdateData(s_editedHeader, s_editedValue);
+						current_project->loadedFile.UpdateValue(id, s_editedHeader, s_editedValue);
 					}
 				}
 			}
@@ -1562,6 +1853,7 @@ namespace ui {
 		}
 		ImGui::EndChild();
 		ImGui::End();
+		GroupResultWindow();
 	}
 	static void UpdateWindow() {
 		float screenW = static_cast<float>(GetScreenWidth());
@@ -1593,7 +1885,9 @@ namespace ui {
 	void HandleUI() {
 		rlImGuiBegin();
 
+		current_project->CheckFileChanges();
 		MainMenu();
+		JobsWindow();
 		
 		switch (uiSettings.ui_mode) {
 		case UI_PROJECT_WINDOW:
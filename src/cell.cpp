@@ -0,0 +1,108 @@
+/*
+MIT License
+
+Copyright (c) 2025 Adrian Jahraus
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "cell.h"
+#include "utils.h"
+#include <charconv>
+
+Cell ParseCell(std::string_view text) {
+	Cell cell;
+	if (text.empty())
+		return cell;
+	if (text[0] == '=') {
+		cell.type = CELL_FORMULA;
+		return cell;
+	}
+	cell.type = CELL_TEXT;
+	// Longer values are always text
+	if (text.size() >= 32)
+		return cell;
+	const char* end = text.data() + text.size();
+	int64_t integer = 0;
+	auto [ptr, ec] = std::from_chars(text.data(), end, integer);
+	if (ec == std::errc() && ptr == end) {
+		// Leading zeros and signs stay text, more than 15 digits would get rounded by excel
+		const size_t digits = text.size() - (text[0] == '-' ? 1 : 0);
+		if (digits <= 15 && std::to_string(integer) == text) {
+			cell.type = CELL_INTEGER;
+			cell.integer = integer;
+		}
+		return cell;
+	}
+	// Numbers use the german ',' as separator, text with a '.' is no number like when writing files
+	if (text.find(',') == std::string_view::npos || text.find('.') != std::string_view::npos)
+		return cell;
+	double number = 0.0;
+	if (StrToNumber(std::string(text), number)) {
+		cell.type = CELL_NUMBER;
+		cell.number = number;
+	}
+	return cell;
+}
+
+Cell ParseDateCell(std::string_view text) {
+	Cell cell = ParseCell(text);
+	if (cell.type == CELL_INTEGER) {
+		const double serial = static_cast<double>(cell.integer);
+		cell.type = CELL_DATE;
+		cell.number = serial;
+	}
+	else if (cell.type == CELL_NUMBER) {
+		cell.type = CELL_DATE;
+	}
+	else if (cell.type == CELL_TEXT) {
+		const std::string date(text);
+		int serial = 0;
+		if (DateToExcelSerial(date, serial) && ExcelSerialToDate(serial) == date) {
+			cell.type = CELL_DATE;
+			cell.number = static_cast<double>(serial);
+		}
+	}
+	return cell;
+}
+
+std::string FormatCell(const Cell& cell, std::string_view text) {
+	switch (cell.type) {
+	case CELL_INTEGER:
+		return std::to_string(cell.integer);
+	case CELL_NUMBER:
+		return NumberToStr(cell.number);
+	case CELL_DATE:
+		return ExcelSerialToDate(static_cast<int>(cell.number));
+	case CELL_EMPTY:
+		return "";
+	default:
+		return std::string(text);
+	}
+}
+
+bool KeepsCellText(const Cell& cell, std::string_view text) {
+	if (!IsNumericCell(cell))
+		return true;
+	return cell.type == CELL_NUMBER && NumberToStr(cell.number) != text;
+}
+
+bool IsNumericCell(const Cell& cell) {
+	return cell.type == CELL_INTEGER || cell.type == CELL_NUMBER || cell.type == CELL_DATE;
+}
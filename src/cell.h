@@ -0,0 +1,61 @@
+/*
+MIT License
+
+Copyright (c) 2025 Adrian Jahraus
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+// Type of a loaded value. Numbers and dates are parsed once when they are loaded or edited
+// and only turned back into text for display and export
+enum CellType : uint8_t {
+	CELL_EMPTY = 0,
+	CELL_TEXT,
+	CELL_INTEGER,
+	CELL_NUMBER,
+	CELL_DATE,		// Excel serial, displayed as dd.mm.yyyy
+	CELL_FORMULA	// Text starting with '='
+};
+
+struct Cell {
+	CellType type = CELL_EMPTY;
+	union {
+		int64_t integer = 0;	// CELL_INTEGER
+		double number;			// CELL_NUMBER and CELL_DATE
+	};
+};
+
+// Types text as integer, number with ',' as separator or formula. Text only becomes an integer
+// if formatting it gives back the same text, so leading zeros and long ids stay text
+Cell ParseCell(std::string_view text);
+// Like ParseCell but numbers are excel serials and dd.mm.yyyy text is a date as well
+Cell ParseDateCell(std::string_view text);
+// Text of a cell the way it is displayed and exported, text is returned for text and formulas
+std::string FormatCell(const Cell& cell, std::string_view text = {});
+// True for integers, numbers and dates, their text is generated by FormatCell
+bool IsNumericCell(const Cell& cell);
+// True if the text of a cell has to be stored, because FormatCell would not give it back.
+// Dates are always displayed formatted
+bool KeepsCellText(const Cell& cell, std::string_view text);
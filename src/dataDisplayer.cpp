@@ -2,125 +2,272 @@
 #include <imgui.h>
 #include "utils.h"
 #include "ui_helper.h"
+#include <unordered_map>
+#include <string_view>
 
 
-void DisplayData(RowInfo &data, const unsigned int identifier, const std::string &mode, const std::vector<std::string> &hiddenHeaders) {
-	// Drawing vertical with headers on right side
-	if (mode == "vertical-rightheader") {
-		int headerfix = 0;	// Needed for labels to not have multiple with same name
-		for (auto& rdata : data.GetData()) {
-			// Check if this value should be hidden and skip if it is in hiddenHeaders
-			auto it = std::find(hiddenHeaders.begin(), hiddenHeaders.end(), rdata.first);
-			if (it != hiddenHeaders.end()) {
-				if (*it == rdata.first)
-					continue;
-			}
-			// Generate strings to evaluate everything for InputStringWithHint
-			std::string label = rdata.first + " ## " + std::to_string(identifier) + std::to_string(headerfix);
-			std::string value = rdata.second;
-			std::string headersplit = Splitlines(rdata.first, " ##").first;
-			// Display the inputbox with hint
+// Bumped by DisplayedHeadersChanged(), everything built from the headers before is made again
+static uint64_t s_headersGeneration = 1;
+
+void DisplayedHeadersChanged() {
+	s_headersGeneration++;
+}
+
+// Display names and hidden columns of a row layout, they are only made again when the headers change
+struct ColumnNames {
+	const RowLayout* layout = nullptr;
+	uint64_t layoutGeneration = 0;	// Generation of the layout the names were made from
+	uint64_t headersGeneration = 0;	// s_headersGeneration they were made with
+	std::vector<std::string> names;		// Headers without everything after " ##"
+	std::vector<uint64_t> hiddenMask;	// One bit per column that is not displayed
+
+	bool IsHidden(const size_t x) const {
+		return (hiddenMask[x / 64] >> (x % 64)) & 1;
+	}
+};
+// Only a few layouts are displayed at once, the oldest one gets replaced
+static constexpr size_t s_maxColumnNames = 8;
+static std::vector<ColumnNames> s_columnNames;
+
+static const ColumnNames& s_GetColumnNames(const RowLayout* layout, const std::vector<std::string>& hiddenHeaders) {
+	static const std::vector<std::string> noHeaders;
+	const uint64_t layoutGeneration = layout ? layout->generation : 0;
+	for (const ColumnNames& names : s_columnNames) {
+		if (names.layout == layout && names.layoutGeneration == layoutGeneration && names.headersGeneration == s_headersGeneration)
+			return names;
+	}
+	if (s_columnNames.size() >= s_maxColumnNames)
+		s_columnNames.erase(s_columnNames.begin());
+	const std::vector<std::string>& headers = layout ? layout->headers : noHeaders;
+	ColumnNames& names = s_columnNames.emplace_back();
+	names.layout = layout;
+	names.layoutGeneration = layoutGeneration;
+	names.headersGeneration = s_headersGeneration;
+	names.hiddenMask.assign(headers.size() / 64 + 1, 0);
+	for (size_t x = 0; x < headers.size(); x++) {
+		names.names.push_back(Splitlines(headers[x], " ##").first);
+		if (std::find(hiddenHeaders.begin(), hiddenHeaders.end(), headers[x]) != hiddenHeaders.end())
+			names.hiddenMask[x / 64] |= uint64_t(1) << (x % 64);
+	}
+	return names;
+}
+
+bool DisplayData(const RowInfo& data, const unsigned int identifier, std::string& editedHeader, std::string& editedValue, const std::string& mode, const std::vector<std::string>& hiddenHeaders) {
+	const bool rightHeader = mode == "vertical-rightheader";
+	const bool leftHeader = mode == "vertical-leftheader";
+	const bool aboveHeader = mode == "horizontal-aboveheader";
+	const bool noHeader = mode == "horizontal-noheader";
+	if (!rightHeader && !leftHeader && !aboveHeader && !noHeader)
+		return false;
+	const RowLayout* layout = data.GetLayout();
+	const ColumnNames& columns = s_GetColumnNames(layout, hiddenHeaders);
+	// Values are copied into the same buffer every time, so it only grows and never gets freed
+	static std::string value;
+	// Labels are only shown, the ids come from the row and column instead
+	ImGui::PushID(static_cast<int>(identifier));
+	bool first = true;
+	bool edited = false;
+	for (size_t x = 0; x < data.Size() && x < columns.names.size(); x++) {
+		// Check if this value should be hidden
+		if (columns.IsHidden(x))
+			continue;
+		const std::string& header = layout->headers[x];
+		const char* name = columns.names[x].c_str();
+		data.GetValue(x, value);
+		ImGui::PushID(static_cast<int>(x));
+		bool changed = false;
+		// Drawing vertical with headers on right side, everything after "##" of the header is not shown
+		if (rightHeader) {
 			ImGui::SetNextItemWidth(DEFAULT_INPUT_WIDTH);
-			if(ImGui::InputStringWithHint(value, label, headersplit.c_str()))
-				data.UpdateData(rdata.first, value);
-			ImGui::SetItemTooltip(headersplit.c_str());
-			headerfix++;
+			changed = ImGui::InputStringWithHint(value, header.c_str(), name);
 		}
-		ImGui::Separator();
-	}
-	// Drawing vertical with headers on left side
-	else if (mode == "vertical-leftheader") {
-		int headerfix = 0;	// Needed to avoid multiple same labels
-		for (auto& rdata : data.GetData()) {
-			// Check if this one should be skipped
-			auto it = std::find(hiddenHeaders.begin(), hiddenHeaders.end(), rdata.first);
-			if (it != hiddenHeaders.end()) {
-				if (*it == rdata.first)
-					continue;
-			}
-			// Generate string to evaluate everything for INputStringWithHint
-			std::string headersplit = Splitlines(rdata.first, " ##").first;
-			std::string label = "## " + headersplit + std::to_string(identifier) + std::to_string(headerfix);
-			std::string value = rdata.second;
-			// Display the data and inputbox
-			ImGui::Text("%s", headersplit.c_str());
+		// Drawing vertical with headers on left side
+		else if (leftHeader) {
+			ImGui::Text("%s", name);
 			ImGui::SameLine();
 			ImGui::SetNextItemWidth(DEFAULT_INPUT_WIDTH);
-			label = "## " + label;
-			if (ImGui::InputStringWithHint(value, label, headersplit.c_str()))
-				data.UpdateData(rdata.first, value);
-			ImGui::SetItemTooltip(headersplit.c_str());
-			headerfix++;
+			changed = ImGui::InputStringWithHint(value, "##value", name);
 		}
-		ImGui::Separator();
-	}
-	// Drawing horizontal with headers above
-	else if (mode == "horizontal-aboveheader") {
-		auto&& dataset = data.GetData();
-		int headerfix = 0;	// Needed to avoid multiple labels with same name
-		for (auto& rdata : dataset) {
-			// Check if this one should be skipped
-			auto it = std::find(hiddenHeaders.begin(), hiddenHeaders.end(), rdata.first);
-			if (it != hiddenHeaders.end()) {
-				continue;
-			}
-			if (rdata != dataset.front() && headerfix > 0)
+		// Drawing horizontal with or without the headers above, each value gets a child window to be put side by side
+		else {
+			if (!first)
 				ImGui::SameLine();
-			// Generate strings to evaluate everything for InputStringWithHint
-			std::string headersplit = Splitlines(rdata.first, " ##").first;
-			std::string label = "## " + headersplit + std::to_string(identifier) + std::to_string(headerfix);
-			std::string childname = label + "_child" + std::to_string(identifier);
-			std::string value = rdata.second;
-			// Begin a new childwindow (to be able to put them all side by side)
-			// Also draw the data and inputbox
-			ImGui::BeginChild(childname.c_str(), {DEFAULT_INPUT_WIDTH, 50.0f});
-			ImGui::Text("%s", headersplit.c_str());
+			ImGui::BeginChild("value", {DEFAULT_INPUT_WIDTH, aboveHeader ? 50.0f : 25.0f});
+			if (aboveHeader)
+				ImGui::Text("%s", name);
 			ImGui::SetNextItemWidth(DEFAULT_INPUT_WIDTH);
-			if (ImGui::InputStringWithHint(value, label, headersplit.c_str())) {
-				data.UpdateData(rdata.first, value);
-			}
-			ImGui::SetItemTooltip(headersplit.c_str());
-			ImGui::EndChild();
-			headerfix++;
+			changed = ImGui::InputStringWithHint(value, "##value", name);
 		}
-		ImGui::Separator();
-	}
-	// Drawing horizontal without headers (Should be drawn before this)
-	else if (mode == "horizontal-noheader") {
-		auto&& dataset = data.GetData();
-		int headerfix = 0;	// Needed to avoid multiple labels with same value
-		for (auto& rdata : dataset) {
-			// Check if this one should be skipped
-			auto it = std::find(hiddenHeaders.begin(), hiddenHeaders.end(), rdata.first);
-			if (it != hiddenHeaders.end()) {
-				continue;
-			}
-			if (rdata != dataset.front() && headerfix > 0)
-				ImGui::SameLine();
-			// Generate strings to evaluate everything for InputStringWithHint
-			std::string headersplit = Splitlines(rdata.first, " ##").first;
-			std::string label = "## " + headersplit + std::to_string(identifier) + std::to_string(headerfix);
-			std::string childname = label + "_child" + std::to_string(identifier);
-			std::string value = rdata.second;
-			// Begin drawing all values
-			ImGui::BeginChild(childname.c_str(), {DEFAULT_INPUT_WIDTH, 25.0f});
-			ImGui::SetNextItemWidth(DEFAULT_INPUT_WIDTH);
-			if (ImGui::InputStringWithHint(value, label, headersplit.c_str())) {
-				data.UpdateData(rdata.first, value);
-			}
-			ImGui::SetItemTooltip(headersplit.c_str());
-			ImGui::EndChild();
-			headerfix++;
+		if (changed) {
+			editedHeader = header;
+			editedValue = value;
+			edited = true;
 		}
-		ImGui::Separator();
+		ImGui::SetItemTooltip("%s", name);
+		if (aboveHeader || noHeader)
+			ImGui::EndChild();
+		ImGui::PopID();
+		first = false;
 	}
-
+	ImGui::PopID();
+	ImGui::Separator();
+	return edited;
 }
 
 void DisplayDataset(std::vector<RowInfo>& data, const std::string& mode, const std::vector<std::string>& hiddenHeaders) {
 	int idx = 0;
+	std::string header, value;
 	for (auto& rowinfo : data) {
-		DisplayData(rowinfo, idx, mode, hiddenHeaders);
+		if (DisplayData(rowinfo, idx, header, value, mode, hiddenHeaders))
+			rowinfo.UpdateData(header, value);
 		idx++;
 	}
-}
\ No newline at end of file
+}
+
+// Cell of the table that is edited right now, the value is kept between the frames.
+// The row is kept as its record, the position it was drawn at tells if the order changed since
+static int s_editRecord = -1;
+static int s_editPosition = -1;
+static int s_editColumn = -1;
+static std::string s_editValue;
+static bool s_editFocus = false;
+
+void CancelDataTableEdit() {
+	s_editRecord = -1;
+	s_editPosition = -1;
+	s_editFocus = false;
+}
+
+// Columns of the table and where they are inside the layout of the rows, kept between the frames
+// until the headers or the layout change
+struct TableColumns {
+	uint64_t headersGeneration = 0;	// s_headersGeneration the columns were made with
+	size_t headerCount = 0;
+	std::vector<int> columns;	// Index of every displayed column inside the headers of the table
+	const RowLayout* layout = nullptr;
+	uint64_t layoutGeneration = 0;
+	std::vector<int> layoutIndex;	// Index of every displayed column inside layout, -1 if it does not have it
+};
+static TableColumns s_tableColumns;
+
+void DisplayDataTable(const std::vector<std::string>& headers, const int rowCount, const std::function<const RowInfo&(int)>& getRow,
+	const std::function<int(int)>& getRecord, const std::function<void(int, const RowInfo&)>& setRow, const std::function<void(int)>& removeRow,
+	const std::vector<std::string>& hiddenHeaders) {
+	// Hidden headers are left out as columns, ImGui tables can not have more than 512 columns.
+	// The buffers are kept between the frames so drawing does not allocate
+	TableColumns& table = s_tableColumns;
+	const std::vector<int>& columns = table.columns;
+	std::vector<int>& layoutIndex = table.layoutIndex;
+	static std::string value;
+	if (table.headersGeneration != s_headersGeneration || table.headerCount != headers.size()) {
+		table.headersGeneration = s_headersGeneration;
+		table.headerCount = headers.size();
+		table.columns.clear();
+		for (size_t x = 0; x < headers.size() && table.columns.size() < 511; x++) {
+			if (std::find(hiddenHeaders.begin(), hiddenHeaders.end(), headers[x]) == hiddenHeaders.end())
+				table.columns.push_back(static_cast<int>(x));
+		}
+		// The layout indexes belong to the old columns
+		table.layout = nullptr;
+		layoutIndex.clear();
+	}
+	const ImGuiTableFlags flags = ImGuiTableFlags_ScrollX | ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersV
+		| ImGuiTableFlags_BordersOuter | ImGuiTableFlags_Resizable | ImGuiTableFlags_SizingFixedFit;
+	if (!ImGui::BeginTable("datatable", static_cast<int>(columns.size()) + 1, flags))
+		return;
+	// The delete buttons and the headers stay visible while scrolling
+	ImGui::TableSetupScrollFreeze(1, 1);
+	ImGui::TableSetupColumn("##remove", ImGuiTableColumnFlags_WidthFixed | ImGuiTableColumnFlags_NoHide);
+	for (const int column : columns) {
+		// Everything after "##" is not displayed by ImGui, so the headers can be used as they are
+		ImGui::TableSetupColumn(headers[column].c_str(), ImGuiTableColumnFlags_WidthFixed, DEFAULT_INPUT_WIDTH);
+	}
+	ImGui::TableHeadersRow();
+
+	int removed = -1;
+	bool editDrawn = false;
+	const float rowHeight = ImGui::GetFrameHeight();
+	ImGuiListClipper clipper;
+	clipper.Begin(rowCount);
+	while (clipper.Step()) {
+		for (int r = clipper.DisplayStart; r < clipper.DisplayEnd; r++) {
+			const RowInfo& row = getRow(r);
+			const int record = getRecord(r);
+			// Rows share their layout most of the time, so the columns are only looked up when it changes
+			const RowLayout* layout = row.GetLayout();
+			const uint64_t layoutGeneration = layout ? layout->generation : 0;
+			if (layout != table.layout || layoutGeneration != table.layoutGeneration || layoutIndex.size() != columns.size()) {
+				table.layout = layout;
+				table.layoutGeneration = layoutGeneration;
+				layoutIndex.assign(columns.size(), -1);
+				if (layout) {
+					std::unordered_map<std::string_view, int> positions;
+					positions.reserve(layout->headers.size());
+					for (size_t x = 0; x < layout->headers.size(); x++)
+						positions.try_emplace(layout->headers[x], static_cast<int>(x));
+					for (size_t c = 0; c < columns.size(); c++) {
+						auto it = positions.find(headers[columns[c]]);
+						if (it != positions.end())
+							layoutIndex[c] = it->second;
+					}
+				}
+			}
+			ImGui::TableNextRow(0, rowHeight);
+			ImGui::PushID(record);
+			ImGui::TableSetColumnIndex(0);
+			if (ImGui::SmallButton(" X "))
+				removed = r;
+			ImGui::SetItemTooltip((char*)u8"Lscht diesen kompletten Eintrag!");
+			for (int c = 0; c < static_cast<int>(columns.size()); c++) {
+				// Columns outside of the visible area are skipped
+				if (!ImGui::TableSetColumnIndex(c + 1))
+					continue;
+				const std::string& header = headers[columns[c]];
+				// The rows got sorted, filtered or resorted by the edit itself, so the cell is not where it was clicked anymore
+				if (record == s_editRecord && r != s_editPosition)
+					CancelDataTableEdit();
+				if (record == s_editRecord && c == s_editColumn) {
+					editDrawn = true;
+					ImGui::SetNextItemWidth(-1.0f);
+					if (s_editFocus) {
+						ImGui::SetKeyboardFocusHere();
+						s_editFocus = false;
+					}
+					if (ImGui::InputString(s_editValue, "##edit", ImGuiInputTextFlags_AutoSelectAll)) {
+						RowInfo edited = row;
+						edited.UpdateData(header, s_editValue);
+						setRow(r, edited);
+					}
+					// Leaving the input box turns the cell back into text
+					if (!s_editFocus && ImGui::IsItemDeactivated())
+						CancelDataTableEdit();
+					continue;
+				}
+				const int x = layoutIndex[c];
+				if (x >= 0 && x < row.Size())
+					row.GetValue(x, value);
+				else
+					value.clear();
+				ImGui::AlignTextToFramePadding();
+				ImGui::TextUnformatted(value.c_str());
+				if (ImGui::IsItemClicked()) {
+					s_editRecord = record;
+					s_editPosition = r;
+					s_editColumn = c;
+					s_editValue = value;
+					s_editFocus = true;
+				}
+			}
+			ImGui::PopID();
+		}
+	}
+	ImGui::EndTable();
+	// The edited cell got scrolled out of view or its row is gone
+	if (s_editRecord >= 0 && !editDrawn && !s_editFocus)
+		CancelDataTableEdit();
+	// Every record behind the removed one moves up, so the edited record would point to another row
+	if (removed >= 0) {
+		CancelDataTableEdit();
+		removeRow(removed);
+	}
+}
@@ -7,6 +7,7 @@
 
 #include "fileloader.h"
 #include <vector>
+#include <functional>
 
 #define DEFAULT_INPUT_WIDTH 175.0f
 
@@ -16,8 +17,22 @@ enum DATA_DISPLAY_MODES {
 	DATA_DISPLAY_MODE_
 };
 
-// Displays a single RowInfo with a given mode
-void DisplayData(RowInfo &data, const unsigned int identifier, const std::string &mode = "vertical-rightheader", const std::vector<std::string>& hiddenHeaders = std::vector<std::string>());
+// Has to be called once the headers or hidden headers that are displayed change, the columns built from them are kept until then
+void DisplayedHeadersChanged();
+// Displays a single RowInfo with a given mode. Returns true if a value got edited, its header and new value
+// are put into editedHeader and editedValue, so the row only has to be written to when that happens
+bool DisplayData(const RowInfo& data, const unsigned int identifier, std::string& editedHeader, std::string& editedValue,
+	const std::string& mode = "vertical-rightheader", const std::vector<std::string>& hiddenHeaders = std::vector<std::string>());
 // Displays a set of RowInfo with a given mode
 void DisplayDataset(std::vector<RowInfo>& data, const std::string& mode = "vertical-rightheader", const std::vector<std::string>& hiddenHeaders = std::vector<std::string>());
 
+// Displays rowCount rows as a table that only draws the rows and columns on screen. Cells are drawn
+// as text and only become an input box once they are clicked.
+// getRow returns the row at a position and getRecord the index of its record, which identifies the row
+// while it is edited. Edited rows are passed with their position to setRow and rows whose delete button
+// got pressed to removeRow after the table is drawn
+void DisplayDataTable(const std::vector<std::string>& headers, const int rowCount, const std::function<const RowInfo&(int)>& getRow,
+	const std::function<int(int)>& getRecord, const std::function<void(int, const RowInfo&)>& setRow, const std::function<void(int)>& removeRow,
+	const std::vector<std::string>& hiddenHeaders = std::vector<std::string>());
+// Stops editing the cell of the table, the records got replaced or renumbered
+void CancelDataTableEdit();
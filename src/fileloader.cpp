@@ -31,36 +31,234 @@ SOFTWARE.
 #include "logging.h"
 #include "utils.h"
 #include "utf8.h"
+#include "xlsxwriter.h"
+#include "zip.h"
+#include "snapshot.h"
+#include "watcher.h"
 #include <unordered_set>
 #include <codecvt>
+#include <bit>
+#include <cmath>
+#include <numeric>
+#include <execution>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <list>
+#include <cstring>
+#include <charconv>
 
 namespace fs = std::filesystem;
 
+using SheetData = std::vector<std::vector<std::string>>;
+
+// Rows that get written into a file. The rows of the grid are followed by the data rows, which are generated
+// from their RowInfo one at a time, so a loaded file never needs a second copy of all its cells
+class SheetRows {
+public:
+	SheetRows(std::shared_ptr<const SheetData> grid, std::vector<RowInfo> rows = {}, std::unordered_map<std::string, int> columns = {})
+		: m_grid(std::move(grid)), m_rows(std::move(rows)), m_columns(std::move(columns)) {
+		for (const auto& row : *m_grid) {
+			m_width = std::max(m_width, row.size());
+		}
+		for (const auto& [header, column] : m_columns) {
+			m_width = std::max(m_width, static_cast<size_t>(column) + 1);
+		}
+	}
+
+	size_t Size() const {
+		return m_grid->size() + m_rows.size();
+	}
+
+	// Widest row of the sheet
+	size_t Width() const {
+		return m_width;
+	}
+
+	// Data rows are generated into a buffer, the reference is only valid until the next call
+	const std::vector<std::string>& GetRow(const size_t x) const {
+		if (x < m_grid->size())
+			return (*m_grid)[x];
+		BuildRow(x);
+		return m_buffer;
+	}
+
+	// Types of the values of row x, rows of the grid only have their text and get typed from it
+	const std::vector<Cell>& GetCells(const size_t x) const {
+		if (x >= m_grid->size()) {
+			BuildRow(x);
+			return m_cells;
+		}
+		if (x != m_gridCellRow) {
+			m_gridCells.clear();
+			for (const std::string& value : (*m_grid)[x]) {
+				m_gridCells.push_back(ParseCell(value));
+			}
+			m_gridCellRow = x;
+		}
+		return m_gridCells;
+	}
+
+private:
+	// Generates the text and types of data row x into the buffers
+	void BuildRow(const size_t x) const {
+		if (x == m_bufferRow)
+			return;
+		const RowInfo& ri = m_rows[x - m_grid->size()];
+		// Rows share their layout most of the time, so the columns are only looked up when it changes
+		if (ri.GetLayout() != m_layout) {
+			m_layout = ri.GetLayout();
+			m_layoutColumns.clear();
+			for (size_t y = 0; m_layout && y < m_layout->headers.size(); y++) {
+				auto it = m_columns.find(m_layout->headers[y]);
+				m_layoutColumns.push_back(it != m_columns.end() ? it->second : -1);
+			}
+		}
+		m_buffer.resize(m_width);
+		for (auto& value : m_buffer) {
+			value.clear();
+		}
+		m_cells.assign(m_width, Cell());
+		for (size_t y = 0; y < ri.Size() && y < m_layoutColumns.size(); y++) {
+			if (m_layoutColumns[y] <= 0)
+				continue;
+			m_buffer[m_layoutColumns[y]] = ri.GetValue(y);
+			m_cells[m_layoutColumns[y]] = ri.GetCell(y);
+		}
+		m_bufferRow = x;
+	}
+
+	std::shared_ptr<const SheetData> m_grid;
+	std::vector<RowInfo> m_rows;
+	std::unordered_map<std::string, int> m_columns;	// Column of every header inside the header row
+	size_t m_width = 0;
+	mutable std::vector<std::string> m_buffer;
+	mutable std::vector<Cell> m_cells;
+	mutable size_t m_bufferRow = SIZE_MAX;
+	mutable std::vector<Cell> m_gridCells;
+	mutable size_t m_gridCellRow = SIZE_MAX;
+	mutable const RowLayout* m_layout = nullptr;
+	mutable std::vector<int> m_layoutColumns;	// Column of every header of m_layout, -1 if it is not written
+};
+
 // Function predefinitions
 // Checks if a file is intact or not
 static bool s_CheckFile(const std::string& filename);
 std::vector<std::vector<std::string>> s_LoadCSVSheet(const std::string& filename);
 static std::vector<std::vector<std::string>> s_LoadExcelSheet(const std::string& filename);
-static void s_SaveCSVSheet(const std::string& filename, const std::vector<std::vector<std::string>>& excelSheet, const bool overwrite = false, const std::string& sourcefile = "");
-static void s_SaveExcelSheet(const std::string& filename, const std::vector<std::vector<std::string>>& excelSheet, const bool overwrite = false, const std::string& sourcefile = "");
+static bool s_SaveCSVSheet(const std::string& filename, const SheetRows& excelSheet, const bool overwrite = false, const std::string& sourcefile = "");
+// Saves excelSheet into filename, if changes are given only those cells are written and everything else is kept as it is
+static bool s_SaveExcelSheet(const std::string& filename, const SheetRows& excelSheet, const bool overwrite = false, const std::string& sourcefile = "", const SheetChanges* changes = nullptr, jobs::JobStatus* status = nullptr);
+
+// Temporary file in the same directory as path, so it can be renamed onto path
+static fs::path s_TempSavePath(const fs::path& path) {
+	static std::atomic<unsigned int> counter = 0;	// saves can run on several workers at once
+	fs::path name = path.stem();
+	name += ".saving" + std::to_string(counter++);
+	name += path.extension();
+	return path.parent_path() / name;
+}
+
+// Moves the completely written temp file over path in one step, the temp file is removed if that fails
+static bool s_ReplaceWithTemp(const fs::path& temp, const fs::path& path) {
+	std::error_code ec;
+	fs::rename(temp, path, ec);
+	if (ec) {
+		logging::logerror("FILELOADER::s_ReplaceWithTemp Could not replace %s: %s", path.string().c_str(), ec.message().c_str());
+		fs::remove(temp, ec);
+		return false;
+	}
+	return true;
+}
+
+// Saves wb into a temp file next to path, checks that it can be loaded again and renames it onto path.
+// path is either the old or the new file at any time, it is never written partially
+static bool s_SaveWorkbookAtomic(xlnt::workbook& wb, const fs::path& path) {
+	const fs::path temp = s_TempSavePath(path);
+	try {
+		wb.save(temp.wstring());
+		xlnt::workbook check;
+		check.load(temp.wstring());
+	}
+	catch (std::exception& e) {
+		logging::logerror("FILELOADER::s_SaveWorkbookAtomic File got corrupted and will not be saved: %s\n%s", path.string().c_str(), e.what());
+		std::error_code ec;
+		fs::remove(temp, ec);
+		return false;
+	}
+	return s_ReplaceWithTemp(temp, path);
+}
 
 static bool s_CheckFile(const std::string& filename) {
+	// Converting filename to a path
+	fs::path path = filename;
+	const fs::path temp = s_TempSavePath(fs::path("sheets") / "to_check.xlsx");
+	bool intact = true;
 	try {
-		// Converting filename to a path
-		fs::path path = filename;
 		fs::create_directories("sheets");
 		xlnt::workbook wb;
 		// try to load / save and again load the file
 		wb.load(path.wstring());
-		wb.save("sheets/to_check.xlsx");
+		wb.save(temp.wstring());
 		wb.clear();
-		wb.load("sheets/to_check.xlsx");
+		wb.load(temp.wstring());
 	}
 	catch (std::exception& e) {
 		logging::logwarning("FILELOADER::s_CheckFile Error Checking File: %s", e.what());
-		return false;
+		intact = false;
+	}
+	std::error_code ec;
+	fs::remove(temp, ec);
+	return intact;
+}
+
+// Splits content into rows the same way s_SaveCSVSheet writes them: values inside '"' can contain the
+// separator and line breaks and "" stands for a quote. Tabs and '\r' outside of quotes are dropped
+static void s_ParseCSV(std::string_view content, const char separator, std::vector<std::vector<std::string>>& sheetData) {
+	std::vector<std::string> row;
+	std::string value;
+	bool quoted = false;
+	bool rowStarted = false;
+	for (size_t i = 0; i < content.size(); i++) {
+		const char c = content[i];
+		if (quoted) {
+			if (c != '"')
+				value.push_back(c == '\\' ? '/' : c);
+			else if (i + 1 < content.size() && content[i + 1] == '"') {
+				value.push_back('"');
+				i++;
+			}
+			else
+				quoted = false;
+			continue;
+		}
+		if (c == '"') {
+			quoted = true;
+			rowStarted = true;
+		}
+		else if (c == separator) {
+			row.push_back(std::move(value));
+			value.clear();
+			rowStarted = true;
+		}
+		else if (c == '\n') {
+			// This row is done, start a new one
+			row.push_back(std::move(value));
+			value.clear();
+			sheetData.push_back(std::move(row));
+			row.clear();
+			rowStarted = false;
+		}
+		else if (c != '\r' && c != '\t') {
+			value.push_back(c == '\\' ? '/' : c);
+			rowStarted = true;
+		}
+	}
+	// Last row without a line break
+	if (rowStarted) {
+		row.push_back(std::move(value));
+		sheetData.push_back(std::move(row));
 	}
-	return true;
 }
 
 std::vector<std::vector<std::string>> s_LoadCSVSheet(const std::string& filename) {
@@ -99,45 +297,18 @@ std::vector<std::vector<std::string>> s_LoadCSVSheet(const std::string& filename
 			fileContent = fileContent.substr(3);
 		}
 
-		std::istringstream contentStream(fileContent);
-		std::string line;
+		// Check for sep= directive
 		std::string separator = ";";
-		separator.erase(0, separator.find_first_not_of(" \t\r\n"));
-		separator.erase(separator.find_last_not_of(" \t\r\n") + 1);
-
-		int x = 0;
-		while (std::getline(contentStream, line)) {
-			// Clean up line
-			RemoveAllSubstrings(line, "\"");
-			RemoveAllSubstrings(line, "\n");
-			RemoveAllSubstrings(line, "\t");
-			RemoveAllSubstrings(line, "\r");
-			ReplaceAllSubstrings(line, "\\", "/");
-
-			// Check for sep= directive
-			if (x == 0 && line.starts_with("sep=")) {
-				separator = Splitlines(line, "=").second;
-				separator.erase(0, separator.find_first_not_of(" \t\r\n"));
-				separator.erase(separator.find_last_not_of(" \t\r\n") + 1);
-				x++;
-				continue;
-			}
-
-			std::vector<std::string> row;
-			std::pair<std::string, std::string> values = Splitlines(line, separator);
-
-			while (StrContains(values.second, separator)) {
-				row.push_back(values.first);
-				values = Splitlines(values.second, separator);
-			}
-
-			// Push remaining values
-			row.push_back(values.first);
-			row.push_back(values.second);
-
-			sheetData.push_back(row);
-			x++;
+		size_t start = 0;
+		if (fileContent.starts_with("sep=")) {
+			start = std::min(fileContent.find('\n'), fileContent.size());
+			separator = fileContent.substr(4, start - 4);
+			separator.erase(0, separator.find_first_not_of(" \t\r\n"));
+			separator.erase(separator.find_last_not_of(" \t\r\n") + 1);
+			if (separator.empty())
+				separator = ";";
 		}
+		s_ParseCSV(std::string_view(fileContent).substr(start), separator[0], sheetData);
 	}
 	catch (const std::exception& e) {
 		logging::logerror("FILELOADER::s_LoadCSVSheet Could not load file: %s\nERROR: %s", filename.c_str(), e.what());
@@ -221,69 +392,239 @@ static std::vector<std::vector<std::string>> s_LoadExcelSheet(const std::string&
 	return sheetData;
 }
 
-static void s_SaveCSVSheet(const std::string& filename, const std::vector<std::vector<std::string>>& excelSheet, const bool overwrite, const std::string& sourcefile) {
+// Windows-1252 bytes 0x80 to 0x9F and the unicode characters they stand for
+static constexpr std::pair<uint16_t, char> s_cp1252Specials[] = {
+	{ 0x20AC, '\x80' }, { 0x201A, '\x82' }, { 0x0192, '\x83' }, { 0x201E, '\x84' }, { 0x2026, '\x85' }, { 0x2020, '\x86' },
+	{ 0x2021, '\x87' }, { 0x02C6, '\x88' }, { 0x2030, '\x89' }, { 0x0160, '\x8A' }, { 0x2039, '\x8B' }, { 0x0152, '\x8C' },
+	{ 0x017D, '\x8E' }, { 0x2018, '\x91' }, { 0x2019, '\x92' }, { 0x201C, '\x93' }, { 0x201D, '\x94' }, { 0x2022, '\x95' },
+	{ 0x2013, '\x96' }, { 0x2014, '\x97' }, { 0x02DC, '\x98' }, { 0x2122, '\x99' }, { 0x0161, '\x9A' }, { 0x203A, '\x9B' },
+	{ 0x0153, '\x9C' }, { 0x017E, '\x9E' }, { 0x0178, '\x9F' }
+};
+
+// Appends a utf-8 value as windows-1252 to out, characters that do not exist there become '?'.
+// Newlines are replaced by spaces and quotes are doubled for quoted csv values
+static void s_AppendCSVValue(std::string& out, const std::string& value, const bool quoted) {
+	const size_t size = value.size();
+	for (size_t i = 0; i < size; i++) {
+		const unsigned char c = static_cast<unsigned char>(value[i]);
+		if (c < 0x80) {
+			if (c == '\n')
+				out.push_back(' ');
+			else if (c == '"' && quoted)
+				out += "\"\"";
+			else
+				out.push_back(static_cast<char>(c));
+			continue;
+		}
+		// Decode the utf-8 sequence
+		uint32_t codepoint = 0;
+		size_t length = 0;
+		if ((c & 0xE0) == 0xC0) { codepoint = c & 0x1F; length = 1; }
+		else if ((c & 0xF0) == 0xE0) { codepoint = c & 0x0F; length = 2; }
+		else if ((c & 0xF8) == 0xF0) { codepoint = c & 0x07; length = 3; }
+		else { out.push_back('?'); continue; }
+		// Sequence cut off at the end of the value
+		if (i + length >= size) {
+			out.push_back('?');
+			break;
+		}
+		bool valid = true;
+		for (size_t k = 1; k <= length; k++) {
+			const unsigned char next = static_cast<unsigned char>(value[i + k]);
+			if ((next & 0xC0) != 0x80) {
+				valid = false;
+				break;
+			}
+			codepoint = (codepoint << 6) | (next & 0x3F);
+		}
+		if (!valid) {
+			out.push_back('?');
+			continue;
+		}
+		i += length;
+		// Latin-1 range and the bytes windows-1252 leaves undefined map to themselves
+		if (codepoint >= 0xA0 && codepoint <= 0xFF
+			|| codepoint == 0x81 || codepoint == 0x8D || codepoint == 0x8F || codepoint == 0x90 || codepoint == 0x9D) {
+			out.push_back(static_cast<char>(codepoint));
+			continue;
+		}
+		char mapped = '?';
+		for (const auto& [unicode, byte] : s_cp1252Specials) {
+			if (unicode == codepoint) {
+				mapped = byte;
+				break;
+			}
+		}
+		out.push_back(mapped);
+	}
+}
+
+// Integers and numbers with ',' as decimal separator are written without quotes
+static bool s_IsCSVNumber(const std::string& value) {
+	size_t i = (value[0] == '+' || value[0] == '-') ? 1 : 0;
+	bool digit = false;
+	int commas = 0, dots = 0;
+	for (; i < value.size(); i++) {
+		const char c = value[i];
+		if (c >= '0' && c <= '9')
+			digit = true;
+		else if (c == ',')
+			commas++;
+		else if (c == '.')
+			dots++;
+		else
+			return false;
+	}
+	return digit && dots == 0 && commas <= 1;
+}
+
+static bool s_SaveCSVSheet(const std::string& filename, const SheetRows& excelSheet, const bool overwrite, const std::string& sourcefile) {
+	Timer t;
+	t.Start();
 	// generate the path
 	fs::path path = fs::u8path(filename);
-	// Open the file
-	std::ofstream file(path.wstring(), std::ios::binary);
+	// Open a temp file that replaces the file once it is written
+	const fs::path temp = s_TempSavePath(path);
+	std::ofstream file(temp.wstring(), std::ios::binary);
 	if (!file) {
 		logging::logwarning("FILELOADER::s_SaveCSVSheet Could not open file: %s", filename.c_str());
-		return;
+		return false;
 	}
+	// Everything is collected in one buffer that is only written once it is full
+	constexpr size_t flushSize = 1 << 20;
+	std::string buffer;
+	buffer.reserve(flushSize + 4096);
 	// Set the separator to be ';'
-	file << ConvertUTF8To1252("sep=;\r\n");
-	// Iterate each row and generate the csv style behavior
-	std::string comma = ",";
-	comma.erase(0, comma.find_first_not_of(" \t\r\n"));
-	comma.erase(comma.find_last_not_of(" \t\r\n") + 1);
-	for (auto&& row : excelSheet) {
-		for (int x = 0; x < row.size(); x++) {
-			std::string val = ConvertUTF8To1252(row[x]);	// Get the data
-			ReplaceAllSubstrings(val, "\n", " ");
-			if (x == 0) {
-				if (val == "")
-					continue;
-				// Check if its a number or int else write the value inside '"'
-				if (IsInteger(val) || IsNumber(val) && StrContains(val, comma)) {
-					file << val;
-				}
-				else {
-					file << '"' << val << '"';
-				}
+	buffer += "sep=;\r\n";
+	for (size_t r = 0; r < excelSheet.Size(); r++) {
+		const std::vector<std::string>& row = excelSheet.GetRow(r);
+		const std::vector<Cell>& cells = excelSheet.GetCells(r);
+		for (size_t x = 0; x < row.size(); x++) {
+			const std::string& val = row[x];
+			if (x > 0)
+				buffer.push_back(';');
+			if (val.empty())
+				continue;
+			// Numbers are written as they are, everything else inside '"'
+			const CellType type = cells[x].type;
+			if (type == CELL_INTEGER || type == CELL_NUMBER || (type == CELL_TEXT && s_IsCSVNumber(val))) {
+				buffer += val;
 			}
 			else {
-				file << ';';
-				if (val == "")
+				buffer.push_back('"');
+				s_AppendCSVValue(buffer, val, true);
+				buffer.push_back('"');
+			}
+		}
+		buffer += "\r\n";	// This row is done, start a new one
+		if (buffer.size() >= flushSize) {
+			file.write(buffer.data(), buffer.size());
+			buffer.clear();
+		}
+	}
+	file.write(buffer.data(), buffer.size());
+	file.close();
+	if (!file) {
+		logging::logerror("FILELOADER::s_SaveCSVSheet Could not write file: %s", filename.c_str());
+		std::error_code ec;
+		fs::remove(temp, ec);
+		return false;
+	}
+	const bool saved = s_ReplaceWithTemp(temp, path);
+	t.Stop();
+	if (IsTimings())
+		logging::loginfo("FILELOADER::s_SaveCSVSheet %s took %f ms to save", filename.c_str(), t.GetElapsedMilliseconds());
+	return saved;
+}
+
+// Cells covered by merged ranges (except their top left cell) bucketed by row
+struct MergedCells {
+	std::unordered_map<xlnt::row_t, std::vector<bool>> rows;
+};
+
+static MergedCells s_IndexMergedCells(const xlnt::worksheet& ws) {
+	MergedCells merged;
+	// merged_ranges() builds a new vector every call, so it is only read once here
+	for (const auto& range : ws.merged_ranges()) {
+		const xlnt::cell_reference topLeft = range.top_left();
+		const xlnt::cell_reference bottomRight = range.bottom_right();
+		const size_t firstCol = topLeft.column().index;
+		const size_t lastCol = bottomRight.column().index;
+		for (xlnt::row_t row = topLeft.row(); row <= bottomRight.row(); ++row) {
+			std::vector<bool>& covered = merged.rows[row];
+			if (covered.size() <= lastCol)
+				covered.resize(lastCol + 1, false);
+			for (size_t col = firstCol; col <= lastCol; ++col) {
+				if (row == topLeft.row() && col == firstCol)
 					continue;
-				if (IsInteger(val) || IsNumber(val) && StrContains(val, comma)) {
-					file << val;
-				}
-				else {
-					file << '"' << val << '"';
-				}
+				covered[col] = true;
 			}
 		}
-		file << "\r\n";	// This row is done, start a new one
 	}
+	return merged;
+}
+
+// Checks if a cell is part of a merged range without being the one that holds its value
+static bool s_IsMergedCell(const MergedCells& merged, const xlnt::row_t row, const size_t col) {
+	if (merged.rows.empty())
+		return false;
+	auto it = merged.rows.find(row);
+	if (it == merged.rows.end())
+		return false;
+	return col < it->second.size() && it->second[col];
 }
 
-static void s_SaveExcelSheet(const std::string& filename, const std::vector<std::vector<std::string>>& excelSheet, const bool overwrite, const std::string& sourcefile) {
+// Writes excelSheet into a new file without loading it into a workbook first
+static bool s_SaveStreamedSheet(const fs::path& path, const SheetRows& excelSheet, jobs::JobStatus* status) {
 	Timer t;
 	t.Start();
-	size_t sheetSize = 0;
-	for (auto& row : excelSheet) {
-		for (auto& cell : row) {
-			sheetSize += cell.size();
+	const fs::path temp = s_TempSavePath(path);
+	bool written = false;
+	{
+		XlsxStreamWriter writer(temp);
+		for (size_t x = 0; x < excelSheet.Size() && writer.IsGood(); x++) {
+			writer.WriteRow(excelSheet.GetRow(x), excelSheet.GetCells(x));
+			if (status && (x & 1023) == 0)
+				status->SetProgress(static_cast<float>(x) / static_cast<float>(excelSheet.Size()));
 		}
+		written = writer.Close();
+	}
+	if (!written) {
+		logging::logerror("FILELOADER::s_SaveStreamedSheet File could not be written: %s", path.string().c_str());
+		std::error_code ec;
+		fs::remove(temp, ec);
+		return false;
 	}
+	const bool saved = s_ReplaceWithTemp(temp, path);
+	t.Stop();
+	if (IsTimings())
+		logging::loginfo("FILELOADER::s_SaveStreamedSheet %s took %f ms to save %d rows", path.string().c_str(), t.GetElapsedMilliseconds(), static_cast<int>(excelSheet.Size()));
+	return saved;
+}
+
+static bool s_SaveExcelSheet(const std::string& filename, const SheetRows& excelSheet, const bool overwrite, const std::string& sourcefile, const SheetChanges* changes, jobs::JobStatus* status) {
+	Timer t;
+	t.Start();
+	// Failures without an exception leave their reason in the status, the log is shared with other jobs
+	auto fail = [status](const char* reason) {
+		if (status)
+			status->SetStatusText(reason);
+		return false;
+	};
 	// Generate the path
 	fs::path path = fs::u8path(filename);
 	// Get what extension the file has and load csv if extension matches it
 	const std::string extension = path.filename().extension().string();
 	if (extension == ".csv" || extension == ".CSV") {
-		s_SaveCSVSheet(filename, excelSheet, overwrite, sourcefile);
-		return;
+		return s_SaveCSVSheet(filename, excelSheet, overwrite, sourcefile) || fail("CSV Datei konnte nicht geschrieben werden");
 	}
+	// Without a file to keep formatting and formulas from, the rows are streamed into a new file
+	if (overwrite && sourcefile == "" && !changes) {
+		return s_SaveStreamedSheet(path, excelSheet, status) || fail("Datei konnte nicht geschrieben werden");
+	}
+	// Loading, writing and saving take about the same time, so each gets a third of the progress
+	if (status)
+		status->SetProgress(0.0f);
 	// Generate path for source file
 	fs::path sourcepath = fs::u8path(sourcefile);
 	xlnt::workbook wb;
@@ -291,7 +632,7 @@ static void s_SaveExcelSheet(const std::string& filename, const std::vector<std:
 	if (!overwrite) {
 		if (!s_CheckFile(path.string())) {
 			logging::logwarning("FILELOADER::s_SaveExcelSheet filechecking failure for: %s", filename.c_str());
-			return;
+			return fail("Zieldatei konnte nicht geladen werden");
 		}
 		wb.load(path.wstring());
 	}
@@ -305,15 +646,13 @@ static void s_SaveExcelSheet(const std::string& filename, const std::vector<std:
 			wb.load(sourcepath.wstring());
 		}
 	}
+	if (status)
+		status->SetProgress(0.33f);
 	xlnt::worksheet ws = wb.active_sheet();
 	// clearing everything that comes after the sheet
 	// Determine actual size
-	const std::size_t max_row = excelSheet.size();
-	std::size_t max_col = 0;
-	for (const auto& row : excelSheet) {
-		if (row.size() > max_col)
-			max_col = row.size();
-	}
+	const std::size_t max_row = excelSheet.Size();
+	const std::size_t max_col = excelSheet.Width();
 
 	// Get the worksheet's current used range
 	auto used_range = ws.calculate_dimension();
@@ -323,98 +662,401 @@ static void s_SaveExcelSheet(const std::string& filename, const std::vector<std:
 	// Clear rows beyond max_row
 	for (std::size_t row = max_row + 1; row <= used_max_row; ++row) {
 		for (std::size_t col = 1; col <= used_max_col; ++col) {
-			if(!ws.cell(xlnt::cell_reference(col, row)).has_formula() && ws.cell(xlnt::cell_reference(col, row)).has_value())
-				ws.cell(xlnt::cell_reference(col, row)).clear_value();
+			auto cell = ws.cell(xlnt::cell_reference(static_cast<std::uint32_t>(col), static_cast<xlnt::row_t>(row)));
+			if(!cell.has_formula() && cell.has_value())
+				cell.clear_value();
 		}
 	}
 
 	// Clear columns beyond max_col in used rows
 	for (std::size_t row = 1; row <= max_row; ++row) {
 		for (std::size_t col = max_col + 1; col <= used_max_col; ++col) {
-			if(!ws.cell(xlnt::cell_reference(col, row)).has_formula() && ws.cell(xlnt::cell_reference(col, row)).has_value())
-				ws.cell(xlnt::cell_reference(col, row)).clear_value();
-		}
-	}
-	// Setup the german separator 
-	std::string comma = ",";
-	comma.erase(0, comma.find_first_not_of(" \t\r\n"));
-	comma.erase(comma.find_last_not_of(" \t\r\n") + 1);
-	// Iterate and write to the excel sheet's cells
-	for (int x = 0; x < excelSheet.size(); x++) {
-		for (int y = 0; y < excelSheet[x].size(); y++) {
-			xlnt::cell_reference cell_ref = xlnt::cell_reference(y + 1, x + 1);
-			auto dest_cell = ws.cell(cell_ref);
-			// Check if it is a merged cell
-			bool skip = false;
-			for (const auto& range : ws.merged_ranges()) {
-				if (range.contains(cell_ref) && cell_ref != range.top_left()) {
-					skip = true;
-					break;
-				}
+			auto cell = ws.cell(xlnt::cell_reference(static_cast<std::uint32_t>(col), static_cast<xlnt::row_t>(row)));
+			if(!cell.has_formula() && cell.has_value())
+				cell.clear_value();
+		}
+	}
+	const MergedCells merged = s_IndexMergedCells(ws);
+	// Dates are written as serials and shown in the german format
+	const xlnt::number_format dateFormat("dd.mm.yyyy");
+	// Writes a single value of the excelSheet into its cell
+	auto writeCell = [&](const int x, const int y) {
+		// Check if it is a merged cell
+		if (s_IsMergedCell(merged, x + 1, y + 1))
+			return;
+		xlnt::cell_reference cell_ref = xlnt::cell_reference(y + 1, x + 1);
+		auto dest_cell = ws.cell(cell_ref);
+		if (dest_cell.has_formula()) {
+			logging::loginfo("Skipping this cell: %d:%d", y+1, x+1);
+			return;
+		}
+		// Retrieve data from the excelSheet that should be written into the cell
+		const std::string& value = excelSheet.GetRow(x)[y];
+		const Cell& cell = excelSheet.GetCells(x)[y];
+
+		if (cell.type == CELL_FORMULA) {
+			dest_cell.formula(value);
+			return;
+		}
+
+		// Numbers and dates were typed while loading, write them without parsing again
+		if (IsNumericCell(cell)) {
+			const double number = cell.type == CELL_INTEGER ? static_cast<double>(cell.integer) : cell.number;
+			if (dest_cell.data_type() == xlnt::cell_type::number && dest_cell.value<double>() == number)
+				return;
+			if (cell.type == CELL_INTEGER) {
+				dest_cell.value(static_cast<long long>(cell.integer));
+				dest_cell.number_format(xlnt::number_format::number());
 			}
-			if (dest_cell.has_formula()) {
-				logging::loginfo("Skipping this cell: %d:%d", y+1, x+1);
-				skip = true;
+			else if (cell.type == CELL_DATE) {
+				dest_cell.value(number);
+				dest_cell.number_format(dateFormat);
 			}
-			// Retrieve data from the excelSheet that should be written into the cell
-
-			if (skip)
-				continue;
-			std::string value = excelSheet[x][y];
+			else
+				dest_cell.value(number);
+			return;
+		}
 
-			if (dest_cell.to_string() == value)
-				continue;
+		if (dest_cell.to_string() == value)
+			return;
 
-			if (value[0] == '=') {
-				dest_cell.formula(value);
+		// Asign cell value string
+		if (!IsValidUTF8(value)) {
+			std::string cleaned;
+			utf8::replace_invalid(value.begin(), value.end(), std::back_inserter(cleaned));
+			dest_cell.value(cleaned);
+		}
+		else {
+			dest_cell.value(value);
+			if(value != "")
+				dest_cell.number_format(xlnt::number_format::text());
+		}
+	};
+	// Iterate and write to the excel sheet's cells, either all of them or only the changed ones
+	size_t cellsWritten = 0;
+	const size_t firstFullRow = changes ? changes->firstFullRow : 0;
+	if (changes) {
+		for (const auto& [x, y] : changes->cells) {
+			if (x >= firstFullRow || x >= excelSheet.Size() || y >= excelSheet.GetRow(x).size())
 				continue;
-			}
+			writeCell(static_cast<int>(x), static_cast<int>(y));
+			cellsWritten++;
+		}
+	}
+	for (int x = static_cast<int>(firstFullRow); x < excelSheet.Size(); x++) {
+		const size_t rowSize = excelSheet.GetRow(x).size();
+		for (int y = 0; y < rowSize; y++) {
+			writeCell(x, y);
+			cellsWritten++;
+		}
+		if (status && (x & 1023) == 0)
+			status->SetProgress(0.33f + 0.33f * static_cast<float>(x) / static_cast<float>(excelSheet.Size()));
+	}
+	if (status)
+		status->SetProgress(0.66f);
+	// Save the file
+	const bool saved = s_SaveWorkbookAtomic(wb, path);
+	t.Stop();
+	if(IsTimings())
+		logging::loginfo("FILELOADER::s_SaveExcelSheet %s took %f ms to save %d cells", filename.c_str(), t.GetElapsedMilliseconds(), static_cast<int>(cellsWritten));
+	return saved || fail("Datei konnte nicht geschrieben werden");
+}
+
+// HyperLogLog with 2^10 registers, the distinct estimate is off by about 3%
+static constexpr int s_hllBits = 10;
+static constexpr size_t s_hllRegisters = size_t(1) << s_hllBits;
+
+static uint64_t s_HashValue(const std::string& value) {
+	uint64_t hash = std::hash<std::string>{}(value);
+	// splitmix64 finalizer as std::hash does not have to spread the bits evenly
+	hash ^= hash >> 30;
+	hash *= 0xbf58476d1ce4e5b9ULL;
+	hash ^= hash >> 27;
+	hash *= 0x94d049bb133111ebULL;
+	hash ^= hash >> 31;
+	return hash;
+}
+
+static void s_AddToColumnStats(ColumnStats& stats, const RowInfo& row, const std::string& header) {
+	stats.rows++;
+	const std::string value = row.GetData(header);
+	if (value == "") {
+		stats.emptyCount++;
+		return;
+	}
+	double number;
+	if (row.GetNumber(header, number)) {
+		if (stats.numericCount == 0 || number < stats.min)
+			stats.min = number;
+		if (stats.numericCount == 0 || number > stats.max)
+			stats.max = number;
+		stats.sum += number;
+		stats.numericCount++;
+	}
+	// First bits select the register, the leading zeros of the rest are the rank
+	const uint64_t hash = s_HashValue(value);
+	const size_t reg = static_cast<size_t>(hash >> (64 - s_hllBits));
+	const uint64_t rest = (hash << s_hllBits) | (uint64_t(1) << (s_hllBits - 1));
+	const uint8_t rank = static_cast<uint8_t>(std::countl_zero(rest) + 1);
+	if (stats.registers[reg] < rank)
+		stats.registers[reg] = rank;
+}
+
+static void s_UpdateDistinctEstimate(ColumnStats& stats) {
+	const double m = static_cast<double>(s_hllRegisters);
+	double sum = 0.0;
+	size_t zeros = 0;
+	for (uint8_t reg : stats.registers) {
+		sum += 1.0 / static_cast<double>(uint64_t(1) << reg);
+		if (reg == 0)
+			zeros++;
+	}
+	double estimate = (0.7213 / (1.0 + 1.079 / m)) * m * m / sum;
+	// Small cardinalities are way more precise with linear counting
+	if (estimate <= 2.5 * m && zeros > 0)
+		estimate = m * std::log(m / static_cast<double>(zeros));
+	stats.distinctEstimate = static_cast<size_t>(estimate + 0.5);
+}
+
+const ColumnStats& FileInfo::GetColumnStats(const std::string& header) {
+	auto it = m_columnstats.find(header);
+	if (it != m_columnstats.end()) {
+		// Appended rows only reset the estimate, so it is rebuilt here once
+		if (it->second.distinctEstimate == 0 && it->second.rows > it->second.emptyCount)
+			s_UpdateDistinctEstimate(it->second);
+		return it->second;
+	}
+	ColumnStats stats;
+	stats.registers.assign(s_hllRegisters, 0);
+	for (const RowInfo& row : m_rowinfo) {
+		s_AddToColumnStats(stats, row, header);
+	}
+	s_UpdateDistinctEstimate(stats);
+	return m_columnstats[header] = std::move(stats);
+}
+
+void FileInfo::InvalidateColumnStats(const std::string& header) {
+	if (header == "")
+		m_columnstats.clear();
+	else
+		m_columnstats.erase(header);
+}
+
+static SortKey s_MakeSortKey(const RowInfo& row, const std::string& header) {
+	SortKey key;
+	const Cell* cell = row.GetCell(header);
+	if (!cell || cell->type == CELL_EMPTY) {
+		key.kind = 2;
+		return key;
+	}
+	// Typed values already know their number, dates sort by their serial
+	if (cell->type == CELL_INTEGER) {
+		key.number = static_cast<double>(cell->integer);
+		return key;
+	}
+	if (cell->type == CELL_NUMBER || cell->type == CELL_DATE) {
+		key.number = cell->number;
+		return key;
+	}
+	const std::string value = row.GetData(header);
+	if (StrToNumber(value, key.number))
+		return key;
+	int serial;
+	if (DateToExcelSerial(value, serial)) {
+		key.number = static_cast<double>(serial);
+		return key;
+	}
+	key.kind = 1;
+	key.text = value;
+	return key;
+}
+
+// Checks if row a comes before row b, empty values stay at the end in both directions
+// and equal values keep their row order so the order is always the same
+static bool s_SortBefore(const SortIndex& index, const int a, const int b) {
+	const SortKey& keyA = index.keys[a];
+	const SortKey& keyB = index.keys[b];
+	if (keyA.kind != keyB.kind) {
+		if (keyA.kind == 2 || keyB.kind == 2)
+			return keyB.kind == 2;
+		return index.ascending ? keyA.kind < keyB.kind : keyA.kind > keyB.kind;
+	}
+	int cmp = 0;
+	if (keyA.kind == 0)
+		cmp = (keyA.number < keyB.number) ? -1 : (keyA.number > keyB.number ? 1 : 0);
+	else if (keyA.kind == 1)
+		cmp = keyA.text.compare(keyB.text);
+	if (cmp != 0)
+		return index.ascending ? cmp < 0 : cmp > 0;
+	return a < b;
+}
+
+// Puts a single row back to its place after its key changed or it was added
+static void s_ResortRow(SortIndex& index, const int row) {
+	auto it = std::find(index.order.begin(), index.order.end(), row);
+	if (it != index.order.end())
+		index.order.erase(it);
+	auto pos = std::lower_bound(index.order.begin(), index.order.end(), row,
+		[&index](const int a, const int b) {
+			return s_SortBefore(index, a, b);
+		});
+	index.order.insert(pos, row);
+}
 
-			// Asign cell integer value
-			if (IsInteger(value) && (value[0] != '0' || value.size() == 1)) {
-				int intval = std::stoi(value);
-				dest_cell.value(intval);
-				dest_cell.number_format(xlnt::number_format::number());
-				continue;
+const std::vector<int>& FileInfo::GetSortedIndex(const std::string& header, const bool ascending) {
+	auto it = m_sortindex.find({ header, ascending });
+	if (it != m_sortindex.end())
+		return it->second.order;
+	Timer t;
+	t.Start();
+	SortIndex index;
+	index.ascending = ascending;
+	index.keys.resize(m_rowinfo.size());
+	index.order.resize(m_rowinfo.size());
+	std::iota(index.order.begin(), index.order.end(), 0);
+	// Parsing the keys touches every cell so it runs in parallel aswell, the rows itself are never moved
+	std::for_each(std::execution::par, index.order.begin(), index.order.end(),
+		[this, &index, &header](const int x) {
+			index.keys[x] = s_MakeSortKey(m_rowinfo[x], header);
+		});
+	std::sort(std::execution::par, index.order.begin(), index.order.end(),
+		[&index](const int a, const int b) {
+			return s_SortBefore(index, a, b);
+		});
+	t.Stop();
+	if (IsTimings())
+		logging::loginfo("FILELOADER::FileInfo::GetSortedIndex sorting %d rows took %f ms", static_cast<int>(m_rowinfo.size()), t.GetElapsedMilliseconds());
+	return (m_sortindex[{ header, ascending }] = std::move(index)).order;
+}
+
+// Partial aggregate of one group, every thread collects its own and they are merged at the end
+struct GroupAggregate {
+	size_t firstRow = 0;	// Used to output the groups in order of their first appearance
+	size_t count = 0;
+	std::vector<double> sums;
+	std::vector<size_t> numericCounts;
+};
+
+void FileInfo::Aggregate(const std::vector<std::string>& groupHeaders, const std::vector<std::string>& valueHeaders, FileInfo& result) const {
+	result.Unload();
+	if (groupHeaders.size() == 0) {
+		logging::logwarning("FILELOADER::FileInfo::Aggregate No header to group by was given");
+		return;
+	}
+	Timer t;
+	t.Start();
+	const size_t rowCount = m_rowinfo.size();
+	// Small sheets are not worth starting threads for
+	size_t threadCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+	threadCount = std::min(threadCount, std::max<size_t>(1, rowCount / 4096));
+	std::vector<std::unordered_map<std::string, GroupAggregate>> partials(threadCount);
+	auto aggregatePart = [&](const size_t part) {
+		const size_t begin = rowCount * part / threadCount;
+		const size_t end = rowCount * (part + 1) / threadCount;
+		auto& groups = partials[part];
+		std::string key;
+		for (size_t x = begin; x < end; x++) {
+			const RowInfo& row = m_rowinfo[x];
+			key.clear();
+			for (const std::string& header : groupHeaders) {
+				key += row.GetData(header);
+				key += '\x1f';	// Unit separator so "a"+"bc" and "ab"+"c" are different groups
 			}
-			
-			// Asign cell value number
-			if (IsNumber(value) && StrContains(value, comma)) {
-				const std::string cell_val = dest_cell.to_string();
-				std::replace(value.begin(), value.end(), ',', '.');
-				if (cell_val == value)
-					continue;
-				dest_cell.value(value, true);
-				continue;
+			auto [it, inserted] = groups.try_emplace(key);
+			GroupAggregate& group = it->second;
+			if (inserted) {
+				group.firstRow = x;
+				group.sums.assign(valueHeaders.size(), 0.0);
+				group.numericCounts.assign(valueHeaders.size(), 0);
 			}
-			// Asign cell value string
-			if (!IsValidUTF8(value)) {
-				std::string cleaned;
-				utf8::replace_invalid(value.begin(), value.end(), std::back_inserter(cleaned));
-				dest_cell.value(cleaned);
+			group.count++;
+			for (size_t v = 0; v < valueHeaders.size(); v++) {
+				double number;
+				if (row.GetNumber(valueHeaders[v], number)) {
+					group.sums[v] += number;
+					group.numericCounts[v]++;
+				}
 			}
-			else {
-				dest_cell.value(value);
-				if(value != "")
-					dest_cell.number_format(xlnt::number_format::text());
+		}
+	};
+	std::vector<std::thread> threads;
+	for (size_t part = 1; part < threadCount; part++) {
+		threads.emplace_back(aggregatePart, part);
+	}
+	aggregatePart(0);
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	// Merge all partial aggregates into the first one
+	auto& merged = partials[0];
+	for (size_t part = 1; part < partials.size(); part++) {
+		for (auto& [key, group] : partials[part]) {
+			auto [it, inserted] = merged.try_emplace(key, std::move(group));
+			if (inserted)
+				continue;
+			GroupAggregate& target = it->second;
+			target.count += group.count;
+			target.firstRow = std::min(target.firstRow, group.firstRow);
+			for (size_t v = 0; v < valueHeaders.size(); v++) {
+				target.sums[v] += group.sums[v];
+				target.numericCounts[v] += group.numericCounts[v];
 			}
 		}
 	}
-	// Save the file
-	try {
-		wb.save("sheets/to_save.xlsx");
-		if (s_CheckFile("sheets/to_save.xlsx")){
-			wb.save(filename);
+	std::vector<const GroupAggregate*> groups;
+	groups.reserve(merged.size());
+	for (auto& [key, group] : merged) {
+		groups.push_back(&group);
+	}
+	std::sort(groups.begin(), groups.end(), [](const GroupAggregate* a, const GroupAggregate* b) {
+		return a->firstRow < b->firstRow;
+	});
+	// Generate the headers of the result the same way LoadFile does
+	std::vector<std::string> names;
+	for (const std::string& header : groupHeaders) {
+		names.push_back(Splitlines(header, " ##").first);
+	}
+	names.push_back("Anzahl");
+	for (const std::string& header : valueHeaders) {
+		const std::string name = Splitlines(header, " ##").first;
+		names.push_back(name + " Summe");
+		names.push_back(name + " Durchschnitt");
+	}
+	// All result rows share one layout like the rows of a loaded file
+	result.m_layout = std::make_shared<RowLayout>();
+	for (int y = 0; y < names.size(); y++) {
+		result.m_headerinfo.push_back(std::make_pair(names[y] + " ##" + std::to_string(y), std::make_pair(0, y + 1)));
+		result.m_headernames.push_back(result.m_headerinfo.back().first);
+		result.m_layout->headers.push_back(result.m_headerinfo.back().first);
+	}
+	result.m_layout->dictionaries.resize(names.size());
+	result.m_layout->dates.resize(names.size(), false);
+	// Generate the rows
+	result.m_rowinfo.reserve(groups.size());
+	for (const GroupAggregate* group : groups) {
+		RowInfo row(result.m_layout);
+		size_t y = 0;
+		const RowInfo& first = m_rowinfo[group->firstRow];
+		for (const std::string& header : groupHeaders) {
+			row.SetValue(y++, first.GetData(header));
 		}
-		else
-			logging::logerror("FILELOADER::s_SaveExcelSheet File got corrupetd: %s", filename.c_str());
-	}
-	catch (std::exception& e) {
-		logging::logerror("FILELOADER::s_SaveExcelSheet File could not be saved: %s", e.what());
+		row.SetValue(y++, std::to_string(group->count));
+		for (size_t v = 0; v < valueHeaders.size(); v++) {
+			const size_t numbers = group->numericCounts[v];
+			row.SetValue(y++, numbers > 0 ? NumberToStr(group->sums[v]) : "");
+			row.SetValue(y++, numbers > 0 ? NumberToStr(group->sums[v] / numbers) : "");
+		}
+		result.m_rowinfo.push_back(std::move(row));
 	}
+	// The result owns its settings, so they are freed together with the last copy of it
+	result.m_ownedsettings = std::make_shared<FileSettings>();
+	result.Settings = result.m_ownedsettings.get();
+	result.Settings->SetParentFile(&result);
+	result.m_isready = true;
 	t.Stop();
-	if(IsTimings())
-		logging::loginfo("FILELOADER::s_SaveExcelSheet %s took %f ms to save", filename.c_str(), t.GetElapsedMilliseconds());
+	logging::loginfo("FILELOADER::FileInfo::Aggregate %d rows grouped into %d groups", static_cast<int>(rowCount), static_cast<int>(groups.size()));
+	if (IsTimings())
+		logging::loginfo("FILELOADER::FileInfo::Aggregate took %f ms using %d threads", t.GetElapsedMilliseconds(), static_cast<int>(threadCount));
 }
 
 void FileInfo::Unload() {
@@ -425,9 +1067,14 @@ void FileInfo::Unload() {
 		rinfo.Unload();
 	}
 	m_rowinfo.clear();
+	m_layout.reset();
+	m_savedrows = 0;
+	m_columnstats.clear();
+	m_sortindex.clear();
 	Settings->Unload();
-	m_sheetData.clear();
+	m_templaterows = std::make_shared<const SheetData>();	// a running save keeps its own reference
 	m_headerinfo.clear();
+	m_headernames.clear();
 	m_filename = "";
 	m_isready = false;
 	m_headeridx = -1;
@@ -457,7 +1104,7 @@ void FileInfo::LoadSettings(const std::string& path){
 		else if (header == "m_mergefile" && value != "") {
 			FileInfo mergefile;
 			mergefile.LoadFile(value);
-			Settings->SetMergeFile(mergefile);
+			Settings->SetMergeFile(std::move(mergefile));
 		}
 		else if (header == "m_mergefolderfile" && value != "") {
 			//Settings->SetMergeFolderTemplate(value);
@@ -550,118 +1197,524 @@ void FileInfo::SaveSettings(const std::string& path){
 	file << "m_mergeif = " << mergeif.first << " := " << mergeif.second << '\n';
 }
 
-void SplitWorksheets(const std::string& filename, const std::string& outdir, const int startindex){
-	if (!StrEndswith(filename, ".xlsx"))
-		return;
-	try {
-		fs::path path = fs::u8path(filename);
-		xlnt::workbook wb;
-		wb.load(path.wstring());
-
-		logging::loginfo("FILELOADER::SplitWorksheets Splitting Worksheet: %s", filename.c_str());
-		logging::loginfo("FILELOADER::SplitWorksheets Output Directory: %s", outdir.c_str());
+// Value of an attribute inside the text of a single xml element
+static std::string s_XmlAttribute(const std::string& element, const std::string& attribute) {
+	const std::string key = " " + attribute + "=\"";
+	size_t start = element.find(key);
+	if (start == std::string::npos)
+		return "";
+	start += key.size();
+	const size_t end = element.find('"', start);
+	if (end == std::string::npos)
+		return "";
+	return element.substr(start, end - start);
+}
+
+static std::string s_XmlUnescape(std::string value) {
+	ReplaceAllSubstrings(value, "&lt;", "<");
+	ReplaceAllSubstrings(value, "&gt;", ">");
+	ReplaceAllSubstrings(value, "&quot;", "\"");
+	ReplaceAllSubstrings(value, "&apos;", "'");
+	ReplaceAllSubstrings(value, "&amp;", "&");
+	return value;
+}
+
+// Calls func with the text of every element named tag inside xml
+template<typename Func>
+static void s_ForEachXmlElement(const std::string& xml, const std::string& tag, Func func) {
+	const std::string open = "<" + tag + " ";
+	size_t pos = xml.find(open);
+	while (pos != std::string::npos) {
+		const size_t end = xml.find('>', pos);
+		if (end == std::string::npos)
+			return;
+		func(xml.substr(pos, end - pos + 1));
+		pos = xml.find(open, end);
+	}
+}
+
+// Resolves the target of a relationship inside the package, base is the folder of the part that has it
+static std::string s_ResolvePartPath(const std::string& base, const std::string& target) {
+	if (target.starts_with("/"))
+		return target.substr(1);
+	std::vector<std::string> parts;
+	std::string combined = base + target;
+	size_t start = 0;
+	while (start <= combined.size()) {
+		size_t end = combined.find('/', start);
+		if (end == std::string::npos)
+			end = combined.size();
+		const std::string part = combined.substr(start, end - start);
+		if (part == "..") {
+			if (!parts.empty())
+				parts.pop_back();
+		}
+		else if (part != "" && part != ".")
+			parts.push_back(part);
+		start = end + 1;
+	}
+	std::string resolved;
+	for (const auto& part : parts) {
+		if (!resolved.empty())
+			resolved += "/";
+		resolved += part;
+	}
+	return resolved;
+}
+
+static std::string s_PartFolder(const std::string& part) {
+	const size_t slash = part.rfind('/');
+	return slash == std::string::npos ? "" : part.substr(0, slash + 1);
+}
+
+// What a single sheet package needs from the source package
+struct PackageSheet {
+	std::string name;	// Sheet name as it is escaped inside the workbook
+	std::string part;	// Path of the worksheet part
+};
+
+struct PackageInfo {
+	std::vector<PackageSheet> sheets;	// All sheets in workbook order, part is empty if it is no worksheet
+	std::string styles, sharedStrings, theme;	// Parts shared by every sheet
+	bool date1904 = false;
+};
+
+static bool s_ReadPackageInfo(ZipReader& zip, PackageInfo& info) {
+	std::string rels;
+	std::string workbookPart = "xl/workbook.xml";
+	if (zip.Read("_rels/.rels", rels)) {
+		s_ForEachXmlElement(rels, "Relationship", [&](const std::string& element) {
+			if (s_XmlAttribute(element, "Type").ends_with("/officeDocument"))
+				workbookPart = s_ResolvePartPath("", s_XmlAttribute(element, "Target"));
+		});
+	}
+	std::string workbook, workbookRels;
+	const std::string folder = s_PartFolder(workbookPart);
+	const std::string relsPart = folder + "_rels/" + workbookPart.substr(folder.size()) + ".rels";
+	if (!zip.Read(workbookPart, workbook) || !zip.Read(relsPart, workbookRels))
+		return false;
+	std::unordered_map<std::string, std::string> targets;	// Relationship id to worksheet part
+	s_ForEachXmlElement(workbookRels, "Relationship", [&](const std::string& element) {
+		if (s_XmlAttribute(element, "TargetMode") == "External")
+			return;
+		const std::string type = s_XmlAttribute(element, "Type");
+		const std::string target = s_ResolvePartPath(folder, s_XmlAttribute(element, "Target"));
+		if (type.ends_with("/worksheet"))
+			targets[s_XmlAttribute(element, "Id")] = target;
+		else if (type.ends_with("/styles"))
+			info.styles = target;
+		else if (type.ends_with("/sharedStrings"))
+			info.sharedStrings = target;
+		else if (type.ends_with("/theme"))
+			info.theme = target;
+	});
+	s_ForEachXmlElement(workbook, "workbookPr", [&](const std::string& element) {
+		const std::string date1904 = s_XmlAttribute(element, "date1904");
+		info.date1904 = date1904 == "1" || date1904 == "true";
+	});
+	const size_t sheetsStart = workbook.find("<sheets>");
+	const size_t sheetsEnd = workbook.find("</sheets>");
+	if (sheetsStart == std::string::npos || sheetsEnd == std::string::npos)
+		return false;
+	s_ForEachXmlElement(workbook.substr(sheetsStart, sheetsEnd - sheetsStart), "sheet", [&](const std::string& element) {
+		PackageSheet sheet;
+		sheet.name = s_XmlAttribute(element, "name");
+		auto it = targets.find(s_XmlAttribute(element, "r:id"));
+		if (it != targets.end())
+			sheet.part = it->second;
+		info.sheets.push_back(sheet);
+	});
+	return !info.sheets.empty();
+}
+
+// Formulas that point to other sheets would break once the sheet is on its own
+static bool s_HasSheetReferences(const std::string& sheetXml) {
+	size_t pos = sheetXml.find("<f");
+	while (pos != std::string::npos) {
+		const char next = pos + 2 < sheetXml.size() ? sheetXml[pos + 2] : '\0';
+		const size_t end = sheetXml.find("</f>", pos);
+		if ((next == '>' || next == ' ') && end != std::string::npos) {
+			const size_t textStart = sheetXml.find('>', pos);
+			if (textStart < end && sheetXml.find('!', textStart) < end)
+				return true;
+		}
+		pos = sheetXml.find("<f", pos + 2);
+	}
+	return false;
+}
 
-		int sheet_index = startindex;
-		for (const auto& sheet_name : wb.sheet_titles()) {
-			try {
-				xlnt::worksheet ws = wb.sheet_by_title(sheet_name);
-
-				// Create a new workbook and add the current sheet to it
-				xlnt::workbook new_wb;
-				xlnt::worksheet new_ws = new_wb.active_sheet();
-				new_ws.title(sheet_name);
-
-				// Copy contents cell by cell
-				for (auto row : ws.rows(false)) {
-					for (auto cell : row) {
-						try {
-							new_ws.cell(cell.reference()).value(cell.to_string());
-						}
-						catch (const std::exception& e) {
-							logging::logwarning("FILELOADER::SplitWorksheets Error in cell: %s", e.what());
-						}
-					}
-				}
-				// Save to file with dynamic name
-				std::string output_filename = outdir + "sheet_" + std::to_string(sheet_index) + "_" + sheet_name + ".xlsx";
-				fs::path out_path = fs::u8path(output_filename);
-				new_wb.save(out_path);
-				logging::loginfo("FILELOADER::SplitWorksheets Saved splitfile: %s", output_filename.c_str());
+// Splits the shared strings part into its <si> items, so every sheet package only gets the strings it uses
+static bool s_ReadSharedStrings(const std::string& xml, std::vector<std::string>& items) {
+	size_t pos = xml.find("<si");
+	while (pos != std::string::npos) {
+		const char next = pos + 3 < xml.size() ? xml[pos + 3] : '\0';
+		if (next != '>' && next != ' ' && next != '/') {
+			pos = xml.find("<si", pos + 3);
+			continue;
+		}
+		const size_t tagEnd = xml.find('>', pos);
+		if (tagEnd == std::string::npos)
+			return false;
+		size_t end = tagEnd + 1;
+		if (xml[tagEnd - 1] != '/') {
+			end = xml.find("</si>", tagEnd);
+			if (end == std::string::npos)
+				return false;
+			end += 5;
+		}
+		items.push_back(xml.substr(pos, end - pos));
+		pos = xml.find("<si", end);
+	}
+	return true;
+}
 
-				++sheet_index;
-			}
-			catch (const std::exception& e) {
-				logging::logwarning("FILELOADER::SplitWorksheets Error in Worksheet: %s\n%s", sheet_name.c_str(), e.what());
-			}
+// Points the shared string cells of sheetXml to a shared strings part that only holds the strings
+// of this sheet, numbered in the order they are first used. Returns false if a cell can not be remapped
+static bool s_RemapSharedStrings(std::string& sheetXml, const std::vector<std::string>& items, std::string& sharedStrings) {
+	std::unordered_map<size_t, size_t> remap;	// Index in the source part to index in the new part
+	std::string result;
+	result.reserve(sheetXml.size());
+	std::string strings;
+	size_t copied = 0;
+	size_t cells = 0;	// All cells with t="s"
+	size_t values = 0;	// Cells with t="s" that point to a string
+	size_t pos = sheetXml.find("<c");
+	while (pos != std::string::npos) {
+		const char next = pos + 2 < sheetXml.size() ? sheetXml[pos + 2] : '\0';
+		const size_t tagEnd = sheetXml.find('>', pos);
+		if (tagEnd == std::string::npos)
+			break;
+		if ((next != ' ' && next != '>') || s_XmlAttribute(sheetXml.substr(pos, tagEnd - pos + 1), "t") != "s") {
+			pos = sheetXml.find("<c", tagEnd);
+			continue;
+		}
+		// Empty cell without a value
+		if (sheetXml[tagEnd - 1] == '/') {
+			cells++;
+			pos = sheetXml.find("<c", tagEnd);
+			continue;
 		}
+		const size_t cellEnd = sheetXml.find("</c>", tagEnd);
+		const size_t valueStart = sheetXml.find("<v>", tagEnd);
+		if (cellEnd == std::string::npos || valueStart > cellEnd)
+			return false;
+		const size_t valueEnd = sheetXml.find("</v>", valueStart);
+		if (valueEnd > cellEnd)
+			return false;
+		size_t index = 0;
+		const char* first = sheetXml.data() + valueStart + 3;
+		const char* last = sheetXml.data() + valueEnd;
+		const auto [ptr, ec] = std::from_chars(first, last, index);
+		if (ec != std::errc() || ptr != last || index >= items.size())
+			return false;
+		const auto [it, inserted] = remap.try_emplace(index, remap.size());
+		if (inserted)
+			strings += items[index];
+		result.append(sheetXml, copied, valueStart + 3 - copied);
+		result += std::to_string(it->second);
+		copied = valueEnd;
+		cells++;
+		values++;
+		pos = sheetXml.find("<c", cellEnd);
+	}
+	// Every t="s" has to belong to a cell that got remapped, otherwise the sheet uses markup this does not know
+	size_t references = 0;
+	for (size_t found = sheetXml.find(" t=\"s\""); found != std::string::npos; found = sheetXml.find(" t=\"s\"", found + 1))
+		references++;
+	if (references != cells)
+		return false;
+	result.append(sheetXml, copied, std::string::npos);
+	sheetXml = std::move(result);
+	sharedStrings = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+		"<sst xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" count=\"" + std::to_string(values)
+		+ "\" uniqueCount=\"" + std::to_string(remap.size()) + "\">" + strings + "</sst>";
+	return true;
+}
+
+// Parts of the source package that every sheet package gets, read once and copied as they are stored
+struct SharedPart {
+	std::string path;	// Path inside the new package
+	std::string contentType;
+	std::string relationType;
+	ZipEntryInfo entry;
+	std::string raw;
+};
+
+// Writes one sheet of the source package into its own package by copying its worksheet part as it is.
+// Sheets with shared strings get their cells remapped to a shared strings part with only their strings,
+// sharedStrings holds the <si> items of the source package or is nullptr if it has none.
+// Returns false if the sheet can not be copied that way, it then has to be copied through xlnt
+static bool s_WriteSheetPackage(ZipReader& zip, const PackageInfo& info, const PackageSheet& sheet, const std::vector<SharedPart>& shared, const std::vector<std::string>* sharedStrings, const fs::path& outPath) {
+	const ZipEntryInfo* entry = sheet.part.empty() ? nullptr : zip.Find(sheet.part);
+	if (!entry)
+		return false;
+	// Drawings, comments, tables and links of the sheet are other parts that are not copied
+	const std::string folder = s_PartFolder(sheet.part);
+	if (zip.Find(folder + "_rels/" + sheet.part.substr(folder.size()) + ".rels"))
+		return false;
+	std::string raw, xml;
+	if (!zip.ReadRaw(*entry, raw) || !ZipReader::Decompress(*entry, raw, xml))
+		return false;
+	if (s_HasSheetReferences(xml))
+		return false;
+	// Only sheets with shared strings have to be rewritten, all others are copied as they are stored
+	std::string strings;
+	const bool remapped = xml.find(" t=\"s\"") != std::string::npos;
+	if (remapped) {
+		if (!sharedStrings || !s_RemapSharedStrings(xml, *sharedStrings, strings))
+			return false;
+		raw.clear();
+		raw.shrink_to_fit();
+	}
+	else {
+		xml.clear();
+		xml.shrink_to_fit();
+	}
+
+	std::string contentTypes = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+		"<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">"
+		"<Default Extension=\"rels\" ContentType=\"application/vnd.openxmlformats-package.relationships+xml\"/>"
+		"<Default Extension=\"xml\" ContentType=\"application/xml\"/>"
+		"<Override PartName=\"/xl/workbook.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sheet.main+xml\"/>"
+		"<Override PartName=\"/xl/worksheets/sheet1.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.worksheet+xml\"/>";
+	std::string workbookRels = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+		"<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+		"<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/worksheet\" Target=\"worksheets/sheet1.xml\"/>";
+	int relationId = 2;
+	for (const SharedPart& part : shared) {
+		contentTypes += "<Override PartName=\"/xl/" + part.path + "\" ContentType=\"" + part.contentType + "\"/>";
+		workbookRels += "<Relationship Id=\"rId" + std::to_string(relationId++) + "\" Type=\"" + part.relationType + "\" Target=\"" + part.path + "\"/>";
+	}
+	if (remapped) {
+		contentTypes += "<Override PartName=\"/xl/sharedStrings.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sharedStrings+xml\"/>";
+		workbookRels += "<Relationship Id=\"rId" + std::to_string(relationId++) + "\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/sharedStrings\" Target=\"sharedStrings.xml\"/>";
+	}
+	contentTypes += "</Types>";
+	workbookRels += "</Relationships>";
+	const std::string workbook = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+		"<workbook xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\">"
+		+ std::string(info.date1904 ? "<workbookPr date1904=\"1\"/>" : "")
+		+ "<sheets><sheet name=\"" + sheet.name + "\" sheetId=\"1\" r:id=\"rId1\"/></sheets></workbook>";
+
+	const fs::path temp = s_TempSavePath(outPath);
+	ZipWriter out;
+	if (!out.Open(temp))
+		return false;
+	out.WriteEntry("[Content_Types].xml", contentTypes);
+	out.WriteEntry("_rels/.rels", "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+		"<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+		"<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/officeDocument\" Target=\"xl/workbook.xml\"/>"
+		"</Relationships>");
+	out.WriteEntry("xl/workbook.xml", workbook);
+	out.WriteEntry("xl/_rels/workbook.xml.rels", workbookRels);
+	if (remapped) {
+		out.WriteEntry("xl/worksheets/sheet1.xml", xml, true);
+		out.WriteEntry("xl/sharedStrings.xml", strings, true);
 	}
-	catch(std::exception & e) {
-		logging::logerror("%s", e.what());
+	else
+		out.WriteRawEntry("xl/worksheets/sheet1.xml", *entry, raw);
+	for (const SharedPart& part : shared) {
+		out.WriteRawEntry("xl/" + part.path, part.entry, part.raw);
 	}
+	if (!out.Close()) {
+		std::error_code ec;
+		fs::remove(temp, ec);
+		return false;
+	}
+	return s_ReplaceWithTemp(temp, outPath);
 }
 
-void ExportWorksheets(const std::string& filename, const std::vector<std::string> sheetnames, const std::string& outdir, const int startindex){
+// Splits the sheets of filename into their own files, all of them if sheetnames is nullptr.
+// Worksheet parts are copied out of the source package as they are, only sheets that can not be
+// copied that way get loaded through xlnt and copied cell by cell
+static bool s_SplitWorkbook(const std::string& filename, const std::vector<std::string>* sheetnames, const std::string& outdir, const int startindex, const char* caller) {
 	if (!StrEndswith(filename, ".xlsx"))
-		return;
+		return false;
+	Timer t;
+	t.Start();
+	bool success = true;
 	try {
 		fs::path path = fs::u8path(filename);
+		logging::loginfo("FILELOADER::%s Splitting Worksheet: %s", caller, filename.c_str());
+		logging::loginfo("FILELOADER::%s Output Directory: %s", caller, outdir.c_str());
+
+		ZipReader zip;
+		PackageInfo info;
+		const bool streamed = zip.Open(path) && s_ReadPackageInfo(zip, info);
+		std::vector<SharedPart> shared;
+		std::vector<std::string> sharedStrings;
+		bool hasSharedStrings = false;
+		if (streamed) {
+			const std::pair<std::string, SharedPart> candidates[] = {
+				{ info.styles, { "styles.xml", "application/vnd.openxmlformats-officedocument.spreadsheetml.styles+xml", "http://schemas.openxmlformats.org/officeDocument/2006/relationships/styles" } },
+				{ info.theme, { "theme/theme1.xml", "application/vnd.openxmlformats-officedocument.theme+xml", "http://schemas.openxmlformats.org/officeDocument/2006/relationships/theme" } }
+			};
+			for (const auto& [source, part] : candidates) {
+				const ZipEntryInfo* entry = source.empty() ? nullptr : zip.Find(source);
+				if (!entry)
+					continue;
+				SharedPart copy = part;
+				copy.entry = *entry;
+				if (zip.ReadRaw(*entry, copy.raw))
+					shared.push_back(std::move(copy));
+			}
+			// Shared strings are split up per sheet, see s_RemapSharedStrings
+			std::string strings;
+			if (!info.sharedStrings.empty() && zip.Read(info.sharedStrings, strings))
+				hasSharedStrings = s_ReadSharedStrings(strings, sharedStrings);
+		}
+		// Fallback for sheets that can not be copied and for packages that can not be read directly
 		xlnt::workbook wb;
-		wb.load(path.wstring());
-
-		logging::loginfo("FILELOADER::ExportWorksheets Splitting Worksheet: %s", filename.c_str());
-		logging::loginfo("FILELOADER::ExportWorksheets Output Directory: %s", outdir.c_str());
+		bool wbLoaded = false;
+		std::vector<std::string> titles;
+		if (streamed) {
+			for (const auto& sheet : info.sheets)
+				titles.push_back(s_XmlUnescape(sheet.name));
+		}
+		else {
+			wb.load(path.wstring());
+			wbLoaded = true;
+			titles = wb.sheet_titles();
+		}
 
 		int sheet_index = startindex;
-		for (const auto& sheet_name : wb.sheet_titles()) {
+		for (size_t i = 0; i < titles.size(); i++) {
+			const std::string& sheet_name = titles[i];
 			try {
-				if (std::find(sheetnames.begin(), sheetnames.end(), sheet_name) == sheetnames.end())
+				if (sheetnames && std::find(sheetnames->begin(), sheetnames->end(), sheet_name) == sheetnames->end())
 					continue;
-				xlnt::worksheet ws = wb.sheet_by_title(sheet_name);
-
-				// Create a new workbook and add the current sheet to it
-				xlnt::workbook new_wb;
-				xlnt::worksheet new_ws = new_wb.active_sheet();
-				new_ws.title(sheet_name);
-
-				// Copy contents cell by cell
-				for (auto row : ws.rows(false)) {
-					for (auto cell : row) {
-						try {
-							new_ws.cell(cell.reference()).value(cell.to_string());
-						}
-						catch (const std::exception& e) {
-							logging::logwarning("FILELOADER::SplitWorksheets Error in cell: %s", e.what());
-						}
-					}
-				}
 				// Save to file with dynamic name
 				std::string output_filename = outdir + "sheet_" + std::to_string(sheet_index) + "_" + sheet_name + ".xlsx";
 				fs::path out_path = fs::u8path(output_filename);
-				new_wb.save(out_path);
-				logging::loginfo("FILELOADER::SplitWorksheets Saved splitfile: %s", output_filename.c_str());
+				if (!streamed || !s_WriteSheetPackage(zip, info, info.sheets[i], shared, hasSharedStrings ? &sharedStrings : nullptr, out_path)) {
+					if (!wbLoaded) {
+						wb.load(path.wstring());
+						wbLoaded = true;
+					}
+					xlnt::worksheet ws = wb.sheet_by_title(sheet_name);
+
+					// Create a new workbook and add the current sheet to it
+					xlnt::workbook new_wb;
+					xlnt::worksheet new_ws = new_wb.active_sheet();
+					new_ws.title(sheet_name);
+
+					// Copy contents cell by cell
+					for (auto row : ws.rows(false)) {
+						for (auto cell : row) {
+							try {
+								new_ws.cell(cell.reference()).value(cell.to_string());
+							}
+							catch (const std::exception& e) {
+								logging::logwarning("FILELOADER::%s Error in cell: %s", caller, e.what());
+							}
+						}
+					}
+					if (!s_SaveWorkbookAtomic(new_wb, out_path)) {
+						success = false;
+						continue;
+					}
+				}
+				logging::loginfo("FILELOADER::%s Saved splitfile: %s", caller, output_filename.c_str());
 
 				++sheet_index;
 			}
 			catch (const std::exception& e) {
-				logging::logwarning("FILELOADER::ExportWorksheets Error in sheet: %s\n%s", sheet_name.c_str(), e.what());
+				logging::logwarning("FILELOADER::%s Error in Worksheet: %s\n%s", caller, sheet_name.c_str(), e.what());
+				success = false;
 			}
 		}
 	}
 	catch(std::exception & e) {
 		logging::logerror("%s", e.what());
+		success = false;
 	}
+	t.Stop();
+	if (IsTimings())
+		logging::loginfo("FILELOADER::%s %s took %f ms to split", caller, filename.c_str(), t.GetElapsedMilliseconds());
+	return success;
+}
+
+bool SplitWorksheets(const std::string& filename, const std::string& outdir, const int startindex){
+	return s_SplitWorkbook(filename, nullptr, outdir, startindex, "SplitWorksheets");
+}
+
+bool ExportWorksheets(const std::string& filename, const std::vector<std::string> sheetnames, const std::string& outdir, const int startindex){
+	return s_SplitWorkbook(filename, &sheetnames, outdir, startindex, "ExportWorksheets");
 }
 
-void EditWorksheet(const std::string& filename, int DATA_row, bool deleteEmptyRows){
+std::vector<std::string> GetWorksheetNames(const std::string& filename) {
+	std::vector<std::string> names;
+	try {
+		const fs::path path = fs::u8path(filename);
+		ZipReader zip;
+		PackageInfo info;
+		if (zip.Open(path) && s_ReadPackageInfo(zip, info)) {
+			for (const auto& sheet : info.sheets)
+				names.push_back(s_XmlUnescape(sheet.name));
+			return names;
+		}
+		xlnt::workbook wb;
+		wb.load(path.wstring());
+		names = wb.sheet_titles();
+	}
+	catch (const std::exception& e) {
+		logging::logwarning("FILELOADER::GetWorksheetNames Could not read %s: %s", filename.c_str(), e.what());
+	}
+	return names;
+}
+
+// Same edit as the xlnt path of EditWorksheet, applied directly to a parsed sheet. Returns the deleted row count
+static int s_EditSheetData(std::vector<std::vector<std::string>>& sheet, const int DATA_row, const bool deleteEmptyRows) {
+	if (DATA_row > 0) {
+		if (sheet.size() < static_cast<size_t>(DATA_row))
+			sheet.resize(DATA_row);
+		for (auto& row : sheet) {
+			row.insert(row.begin(), "");
+		}
+		sheet[DATA_row - 1][0] = "DATA";
+	}
+	// Keep the table rectangular like a worksheet range
+	size_t columns = 0;
+	for (const auto& row : sheet) {
+		columns = std::max(columns, row.size());
+	}
+	for (auto& row : sheet) {
+		row.resize(columns);
+	}
+	int deletedRows = 0;
+	if (deleteEmptyRows) {
+		// Only rows below the last DATA row are removed, compacted in one pass
+		auto first = sheet.begin();
+		for (auto it = sheet.begin(); it != sheet.end(); ++it) {
+			if (!it->empty() && (*it)[0] == "DATA")
+				first = it + 1;
+		}
+		const auto last = std::remove_if(first, sheet.end(), [](const std::vector<std::string>& values) {
+			return std::all_of(values.begin(), values.end(), [](const std::string& value) { return value.empty(); });
+		});
+		deletedRows = static_cast<int>(std::distance(last, sheet.end()));
+		sheet.erase(last, sheet.end());
+	}
+	return deletedRows;
+}
+
+bool EditWorksheet(const std::string& filename, int DATA_row, bool deleteEmptyRows){
+	fs::path path = fs::u8path(filename);
+	bool edited = false;
 	try {
-		fs::path path = fs::u8path(filename);
-		fs::path toLoad = fs::u8path(filename);
 		if (StrEndswith(filename, ".csv")) {
-			s_SaveExcelSheet("sheets/to_edit.xlsx", s_LoadCSVSheet(filename), true);
-			toLoad = fs::path("sheets/to_edit.xlsx");
+			// CSVs are edited as parsed rows, one read and one write
+			std::vector<std::vector<std::string>> sheet = s_LoadCSVSheet(filename);
+			if (sheet.empty())
+				return false;
+			const int deletedRows = s_EditSheetData(sheet, DATA_row, deleteEmptyRows);
+			edited = s_SaveCSVSheet(filename, SheetRows(std::make_shared<const SheetData>(std::move(sheet))), true);
+			if (edited)
+				logging::loginfo("FILELOADER::EditWorksheet Edited worksheet %s: %d and deleted %d rows", filename.c_str(), DATA_row, deletedRows);
+			return edited;
 		}
 		xlnt::workbook wb;
-		wb.load(toLoad);
+		wb.load(path);
 		xlnt::worksheet ws = wb.active_sheet();
 		if (DATA_row > 0) {
 			ws.insert_columns(1, 1);
@@ -670,66 +1723,112 @@ void EditWorksheet(const std::string& filename, int DATA_row, bool deleteEmptyRo
 		}
 		int deletedRows = 0;
 		if (deleteEmptyRows) {
-			auto max_row = ws.highest_row();
-
-			// Start from the bottom to avoid index shifting when deleting rows
-			for (int row = static_cast<int>(max_row); row >= 1; --row) {
-				bool isEmpty = true;
-
-				auto first_cell = ws.cell(xlnt::cell_reference(1, row));  // Column A = 1
-
-				if (first_cell.has_value() && first_cell.to_string() == "DATA") {
-					break;  // Stop deleting rows at the DATA row
+			const xlnt::row_t maxRow = ws.highest_row();
+			const std::uint32_t maxColumn = ws.highest_column().index;
+
+			// One scan finds the filled rows and the last DATA row, rows above it are never deleted
+			std::vector<bool> filled(maxRow + 1, false);
+			xlnt::row_t dataRow = 0;
+			for (auto cells : ws.rows(false)) {
+				for (auto cell : cells) {
+					if (cell.to_string().empty())
+						continue;
+					const xlnt::row_t row = cell.reference().row();
+					filled[row] = true;
+					if (cell.reference().column_index() == 1 && cell.to_string() == "DATA")
+						dataRow = std::max(dataRow, row);
 				}
+			}
 
-				for (auto cell : ws.rows(false)[row - 1]){
-					if (!cell.to_string().empty()) {
-						isEmpty = false;
-						break;
+			// Move every surviving row up to its final position once, then clear the rest
+			xlnt::row_t target = 1;
+			for (xlnt::row_t source = 1; source <= maxRow; ++source) {
+				if (source > dataRow && !filled[source]) {
+					++deletedRows;
+					continue;
+				}
+				if (target != source) {
+					for (std::uint32_t column = 1; column <= maxColumn; ++column) {
+						const xlnt::cell_reference from(column, source);
+						const xlnt::cell_reference to(column, target);
+						if (!ws.has_cell(from)) {
+							if (ws.has_cell(to))
+								ws.clear_cell(to);
+							continue;
+						}
+						xlnt::cell sourceCell = ws.cell(from);
+						xlnt::cell targetCell = ws.cell(to);
+						targetCell.value(sourceCell);
+						if (sourceCell.has_formula())
+							targetCell.formula(sourceCell.formula());
+						if (sourceCell.has_format())
+							targetCell.format(sourceCell.format());
+						else
+							targetCell.clear_format();
 					}
 				}
-
-				if (isEmpty) {
-					ws.delete_rows(row, 1);
-					++deletedRows;
+				++target;
+			}
+			for (xlnt::row_t row = target; row <= maxRow; ++row) {
+				for (std::uint32_t column = 1; column <= maxColumn; ++column) {
+					const xlnt::cell_reference ref(column, row);
+					if (ws.has_cell(ref))
+						ws.clear_cell(ref);
 				}
 			}
 		}
-		if (StrEndswith(filename, ".csv")) {
-			wb.save(toLoad);
-			s_SaveCSVSheet(filename, s_LoadExcelSheet("sheets/to_edit.xlsx"), true);
+		edited = s_SaveWorkbookAtomic(wb, path);
+		if (edited) {
 			logging::loginfo("FILELOADER::EditWorksheet Edited worksheet %s: %d and deleted %d rows", filename.c_str(), DATA_row, deletedRows);
-		}
+		} 
 		else {
-			wb.save("sheets/to_save.xlsx");
-			if (s_CheckFile("sheets/to_save.xlsx")) {
-				wb.save(path);
-				logging::loginfo("FILELOADER::EditWorksheet Edited worksheet %s: %d and deleted %d rows", filename.c_str(), DATA_row, deletedRows);
-			} 
-			else {
-				logging::loginfo("FILELOADER::EditWorksheet File %s Got corrupted while editing and will not be overwritten!", filename.c_str());
-			}
+			logging::loginfo("FILELOADER::EditWorksheet File %s Got corrupted while editing and will not be overwritten!", filename.c_str());
 		}
 	}
 	catch (const std::exception& e) {
 		logging::logerror("FILELOADER::EditWorksheet %s", e.what());
 	}
+	return edited;
+}
+
+static constexpr int s_backupCount = 5;	// Backups that are kept per file
+
+// Path of the count'th backup of path, backup_1 is the newest one
+static fs::path s_BackupPath(const fs::path& path, const int count) {
+	fs::path name = path.filename();
+	name += ".backup_" + std::to_string(count);
+	return path.parent_path() / "backup" / name;
 }
 
 void BackupFile(const std::string& filename){
 	fs::path path = fs::u8path(filename);
-	const fs::path backupPath = path.parent_path() / "backup";
-	fs::create_directory(backupPath);
-	int count = 5;
-	for (int count = 5; count > 1; --count) {
-		const std::string file = backupPath.string() + "/" + path.filename().string() + ".backup_" + std::to_string(count);
-		std::string next_file = backupPath.string() + "/" + path.filename().string() + ".backup_" + std::to_string(count - 1);
-		if (!fs::exists(next_file)) {
+	if (!fs::exists(path))
+		return;	// nothing written yet that could be backed up
+	fs::create_directory(path.parent_path() / "backup");
+	// Rotate by renaming, the oldest backup gets replaced
+	for (int count = s_backupCount; count > 1; --count) {
+		const fs::path previous = s_BackupPath(path, count - 1);
+		if (!fs::exists(previous)) {
 			continue;
 		}
-		fs::copy_file(next_file, file, fs::copy_options::overwrite_existing);
+		fs::rename(previous, s_BackupPath(path, count));
 	}
-	fs::copy_file(path, backupPath.string() + "/" + path.filename().string() + ".backup_1", fs::copy_options::overwrite_existing);
+	// Files are only ever replaced by renaming a new file onto them, never written in place.
+	// So the newest backup can share its data with the file through a hard link and only gets copied
+	// where the filesystem does not support them
+	const fs::path newest = s_BackupPath(path, 1);
+	std::error_code ec;
+	fs::remove(newest, ec);
+	fs::create_hard_link(path, newest, ec);
+	if (ec)
+		fs::copy_file(path, newest, fs::copy_options::overwrite_existing);
+}
+
+void RestoreBackup(const std::filesystem::path& backupfile, const std::filesystem::path& filename) {
+	// The backup can be a hard link of the file, so copying into the file would change the backup too
+	const fs::path temp = s_TempSavePath(filename);
+	fs::copy_file(backupfile, temp, fs::copy_options::overwrite_existing);
+	s_ReplaceWithTemp(temp, filename);
 }
 
 static bool s_timingsEnabled = false;
@@ -745,20 +1844,215 @@ bool IsTimings() {
 	return s_timingsEnabled;
 }
 
-void FileInfo::LoadFile(const std::string& filename) {
+// Parsed sheet of a file inside the file cache
+struct CachedSheet {
+	std::string filename;
+	snapshot::SourceKey key;	// State of the file the sheet was parsed from
+	std::shared_ptr<SheetData> sheet;
+	size_t bytes = 0;
+};
+
+static std::mutex s_cacheMutex;
+static std::list<CachedSheet> s_sheetCache;	// Most recently used first
+static size_t s_sheetCacheBytes = 0;
+static size_t s_sheetCacheBudget = size_t(512) << 20;
+static std::unordered_map<std::string, std::shared_ptr<jobs::JobStatus>> s_prefetching;	// Prefetches that did not finish yet
+
+// Rough memory used by a sheet, short strings are stored inside the string itself
+static size_t s_SheetBytes(const SheetData& sheet) {
+	size_t bytes = sizeof(SheetData) + sheet.capacity() * sizeof(std::vector<std::string>);
+	for (const auto& row : sheet) {
+		bytes += row.capacity() * sizeof(std::string);
+		for (const auto& cell : row) {
+			if (cell.capacity() >= sizeof(std::string))
+				bytes += cell.capacity() + 1;
+		}
+	}
+	return bytes;
+}
+
+// Drops the least recently used sheets until the cache fits its budget again, s_cacheMutex has to be locked
+static void s_TrimSheetCache() {
+	while (s_sheetCacheBytes > s_sheetCacheBudget && !s_sheetCache.empty()) {
+		s_sheetCacheBytes -= s_sheetCache.back().bytes;
+		s_sheetCache.pop_back();
+	}
+}
+
+static std::shared_ptr<SheetData> s_GetCachedSheet(const std::string& filename, const snapshot::SourceKey& key) {
+	std::lock_guard<std::mutex> lock(s_cacheMutex);
+	for (auto it = s_sheetCache.begin(); it != s_sheetCache.end(); ++it) {
+		if (it->filename != filename)
+			continue;
+		// The file changed since it was parsed
+		if (it->key.size != key.size || it->key.time != key.time) {
+			s_sheetCacheBytes -= it->bytes;
+			s_sheetCache.erase(it);
+			return nullptr;
+		}
+		s_sheetCache.splice(s_sheetCache.begin(), s_sheetCache, it);
+		return it->sheet;
+	}
+	return nullptr;
+}
+
+static void s_CacheSheet(const std::string& filename, const snapshot::SourceKey& key, const std::shared_ptr<SheetData>& sheet) {
+	CachedSheet entry{ filename, key, sheet, s_SheetBytes(*sheet) };
+	std::lock_guard<std::mutex> lock(s_cacheMutex);
+	for (auto it = s_sheetCache.begin(); it != s_sheetCache.end(); ++it) {
+		if (it->filename == filename) {
+			s_sheetCacheBytes -= it->bytes;
+			s_sheetCache.erase(it);
+			break;
+		}
+	}
+	s_sheetCacheBytes += entry.bytes;
+	s_sheetCache.push_front(std::move(entry));
+	s_TrimSheetCache();
+}
+
+// Numbers of these columns are excel serials, the header name is the only hint about that
+static bool s_IsDateHeader(const std::string& header) {
+	return StrContains(header, "Date")
+		|| StrContains(header, "Datum")
+		|| StrContains(header, "datum")
+		|| StrContains(header, "date");
+}
+
+// Returns the prepared sheet of filename out of the file cache, its snapshot or by parsing the file, in that order.
+// Only sheets with cache set are put into the file cache, so files that are only read once do not push project files out
+static std::shared_ptr<SheetData> s_AcquireSheet(const std::string& filename, const std::string& snapshotfile, const bool cache) {
+	const fs::path path = fs::u8path(filename);
+	snapshot::SourceKey key;
+	const bool keyed = snapshot::GetSourceKey(path, key);
+	if (keyed) {
+		if (auto cached = s_GetCachedSheet(filename, key))
+			return cached;
+	}
+	auto sheet = std::make_shared<SheetData>();
+	const bool fromSnapshot = keyed && snapshotfile != "" && snapshot::Read(fs::u8path(snapshotfile), path, *sheet);
+	if (!fromSnapshot) {
+		*sheet = s_LoadExcelSheet(filename);
+		// Snapshots hold the parsed sheet, values get typed once the rows are built from it
+		if (keyed && snapshotfile != "" && !sheet->empty()) {
+			jobs::Submit("Snapshot " + filename, [sheet, snapshotfile, path, key](jobs::JobStatus&) {
+				fs::create_directories(fs::u8path(snapshotfile).parent_path());
+				return snapshot::Write(fs::u8path(snapshotfile), path, key, *sheet);
+			}, false);
+		}
+	}
+	if (cache && keyed && !sheet->empty())
+		s_CacheSheet(filename, key, sheet);
+	return sheet;
+}
+
+static constexpr size_t s_dictionaryMinRows = 64;	// Smaller files gain nothing from encoding
+
+// Builds a dictionary for every column of the data rows [first, last) that has at most a quarter distinct values, date columns are skipped
+static std::vector<std::shared_ptr<const ColumnDictionary>> s_BuildDictionaries(const SheetData& sheet, const size_t first, const size_t last, const std::vector<bool>& dates) {
+	const size_t columns = dates.size();
+	std::vector<std::shared_ptr<const ColumnDictionary>> dictionaries(columns);
+	const size_t rows = last > first ? last - first : 0;
+	if (rows < s_dictionaryMinRows)
+		return dictionaries;
+	static const std::string empty;
+	const size_t maxDistinct = rows / 4;
+	for (size_t y = 0; y < columns; y++) {
+		// Dates are displayed formatted, so their loaded text is of no use
+		if (dates[y])
+			continue;
+		auto dictionary = std::make_shared<ColumnDictionary>();
+		bool encode = true;
+		for (size_t x = first; x < last && encode; x++) {
+			const auto& row = sheet[x];
+			dictionary->Add(y + 1 < row.size() ? row[y + 1] : empty);
+			encode = dictionary->Size() <= maxDistinct;
+		}
+		if (encode)
+			dictionaries[y] = std::move(dictionary);
+	}
+	return dictionaries;
+}
+
+void PrefetchFile(const std::string& filename, const std::string& snapshotfile) {
+	std::lock_guard<std::mutex> lock(s_cacheMutex);
+	if (s_prefetching.contains(filename))
+		return;
+	s_prefetching[filename] = jobs::Submit("Laden " + filename, [filename, snapshotfile](jobs::JobStatus& status) {
+		// LoadFile took the file over before this job started, it is parsing the file itself
+		const auto isCurrent = [&]() {
+			auto it = s_prefetching.find(filename);
+			return it != s_prefetching.end() && it->second.get() == &status;
+		};
+		{
+			std::lock_guard<std::mutex> lock(s_cacheMutex);
+			if (!isCurrent())
+				return true;
+		}
+		// Nobody is going to open the file anymore when closing
+		const bool loaded = !jobs::IsStopping() && !s_AcquireSheet(filename, snapshotfile, true)->empty();
+		std::lock_guard<std::mutex> lock(s_cacheMutex);
+		if (isCurrent())
+			s_prefetching.erase(filename);
+		return loaded;
+	}, false);
+}
+
+void SetFileCacheBudget(const size_t bytes) {
+	std::lock_guard<std::mutex> lock(s_cacheMutex);
+	s_sheetCacheBudget = bytes;
+	s_TrimSheetCache();
+}
+
+void ClearFileCache() {
+	std::lock_guard<std::mutex> lock(s_cacheMutex);
+	s_sheetCache.clear();
+	s_sheetCacheBytes = 0;
+}
+
+void InvalidateCachedFile(const std::string& filename) {
+	std::lock_guard<std::mutex> lock(s_cacheMutex);
+	for (auto it = s_sheetCache.begin(); it != s_sheetCache.end(); ++it) {
+		if (it->filename == filename) {
+			s_sheetCacheBytes -= it->bytes;
+			s_sheetCache.erase(it);
+			return;
+		}
+	}
+}
+
+void FileInfo::LoadFile(const std::string& filename, const std::string& snapshotfile, const bool cache) {
 	if (IsReady())
 		Unload();
 	// Clear everything before loading save is save
-	m_sheetData.clear();
 	m_rowinfo.clear();
-	m_sheetData = s_LoadExcelSheet(filename);
+	m_columnstats.clear();
+	m_sortindex.clear();
+	// A prefetch that is already parsing this file gets finished instead of parsing it twice,
+	// one that did not start yet is taken out of s_prefetching so it skips the file once it runs
+	std::shared_ptr<jobs::JobStatus> prefetch;
+	{
+		std::lock_guard<std::mutex> lock(s_cacheMutex);
+		auto it = s_prefetching.find(filename);
+		if (it != s_prefetching.end()) {
+			if (it->second->GetState() == jobs::JOB_PENDING)
+				s_prefetching.erase(it);
+			else
+				prefetch = it->second;
+		}
+	}
+	if (prefetch)
+		prefetch->Wait();
+	// The sheet can be shared with the file cache, so it is only read here
+	const std::shared_ptr<SheetData> sheetData = s_AcquireSheet(filename, snapshotfile, cache);
+	const SheetData& sheet = *sheetData;
 	// Check if there is any data
-	if (m_sheetData.size() <= 0)
+	if (sheet.size() <= 0)
 		return;
 	// Get header index
 	int headerIndex = -1;
 	int idx = 0;
-	for (auto& row : m_sheetData) {
+	for (auto& row : sheet) {
 		idx++;
 		if (row.size() <= 0)
 			continue;
@@ -771,41 +2065,46 @@ void FileInfo::LoadFile(const std::string& filename) {
 		logging::logwarning("FILELOADER::FileInfo::LoadFile Loaded file does not contain 'DATA' in the 'A' Column\n Read the Documentation!");
 		return;
 	}
-	// Processing headerinfo
+	// Processing headerinfo, the rows up to the headers are kept to write them back and the data only lives in m_rowinfo
 	m_headeridx = headerIndex;
-	for (int y = 1; y < m_sheetData[headerIndex].size(); y++) {
+	m_templaterows = std::make_shared<const SheetData>(sheet.begin(), sheet.begin() + headerIndex + 1);
+	m_layout = std::make_shared<RowLayout>();
+	for (int y = 1; y < sheet[headerIndex].size(); y++) {
 		std::pair<int, int> index = std::make_pair(headerIndex, y);
-		std::string header = m_sheetData[headerIndex][y];
+		std::string header = sheet[headerIndex][y];
 		header += " ##" + std::to_string(m_headerinfo.size());
 		m_headerinfo.push_back(std::make_pair(header, index));
+		m_headernames.push_back(header);
+		m_layout->headers.push_back(header);
+		m_layout->dates.push_back(s_IsDateHeader(sheet[headerIndex][y]));
+	}
+	// Data goes until the first row without any value
+	size_t dataEnd = headerIndex + 1;
+	while (dataEnd < sheet.size() && std::any_of(sheet[dataEnd].begin() + std::min<size_t>(1, sheet[dataEnd].size()), sheet[dataEnd].end(),
+		[](const std::string& value) { return value != ""; })) {
+		dataEnd++;
+	}
+	m_layout->dictionaries = s_BuildDictionaries(sheet, headerIndex + 1, dataEnd, m_layout->dates);
+	// Values that are not encoded are copied into a single block of the arena, dates are never stored as text
+	size_t arenaBytes = 0;
+	for (size_t x = headerIndex + 1; x < dataEnd; x++) {
+		const auto& row = sheet[x];
+		for (size_t y = 1; y < row.size() && y <= m_layout->headers.size(); y++) {
+			if (!m_layout->dictionaries[y - 1] && !m_layout->dates[y - 1])
+				arenaBytes += row[y].size();
+		}
 	}
+	m_layout->arena = std::make_shared<CellArena>();
+	m_layout->arena->Reserve(arenaBytes);
 	// Processing RowInfo
-	for (int x = headerIndex + 1; x < m_sheetData.size(); x++) {
-		const auto& row = m_sheetData[x];
-		RowInfo rowinfo;
-		bool dataSet = false;
-		for (int y = 1; y < row.size(); y++) {
-			const std::string& header = m_headerinfo[y-1].first;
-			if (header == "")
-				continue;
-			std::string& value = m_sheetData[x][y];
-			if (value != "")
-				dataSet = true;
-			// Only way for me by now to check if the loaded shit is a date or not
-			if (StrContains(header, "Date")
-				|| StrContains(header, "Datum")
-				|| StrContains(header, "datum")
-				|| StrContains(header, "date")) {
-				if (IsNumber(value))
-					value = ExcelSerialToDate(std::stoi(value));
-			}
-			rowinfo.AddData(header, value);
-		}
-		if(dataSet)
-			m_rowinfo.push_back(rowinfo);
-		else {
-			break;
+	m_rowinfo.reserve(dataEnd - headerIndex - 1);
+	for (size_t x = headerIndex + 1; x < dataEnd; x++) {
+		const auto& row = sheet[x];
+		RowInfo rowinfo(m_layout);
+		for (size_t y = 1; y < row.size() && y <= m_layout->headers.size(); y++) {
+			rowinfo.StoreValue(y - 1, row[y]);
 		}
+		m_rowinfo.push_back(std::move(rowinfo));
 	}
 	// Check if there was no data at all and add one filler data to not crash when saving lol
 	/*
@@ -821,67 +2120,103 @@ void FileInfo::LoadFile(const std::string& filename) {
 	Settings = new FileSettings();
 	Settings->SetParentFile(this);
 	m_filename = filename;
+	m_savedrows = m_rowinfo.size();
 	m_isready = true;
 }
 
 void FileInfo::SaveFile(const std::string& filename) {
-	CreateSheetData();	// convert RowInfo to the m_sheetData
-	if (filename == "")
-		s_SaveExcelSheet(m_filename, m_sheetData, false);
-	else
-		s_SaveExcelSheet(filename, m_sheetData, true);
+	if (filename == "") {
+		// Saving into the loaded file only has to touch what changed since the last save
+		StartSave(m_filename, "", false, true, false);
+		return;
+	}
+	StartSave(filename, "", true, false, false);
 }
 
-void FileInfo::SaveFileAs(const std::string& sourcefile, const std::string& destfile) {
+void FileInfo::SaveFileAs(const std::string& sourcefile, const std::string& destfile, const bool backup) {
 	if (!IsReady()) {
 		logging::logwarning("FILELOADER::FileInfo::SaveFileAs File was never loaded correctly. No Data to save");
 		return;
 	}
-
-	CreateSheetData();	// convert RowInfo to the m_sheetData
-
-	s_SaveExcelSheet(destfile, m_sheetData, false, sourcefile);
+	const bool inPlace = destfile == m_filename && (sourcefile == "" || sourcefile == m_filename);
+	StartSave(destfile, sourcefile, false, inPlace, backup);
+}
+
+std::shared_ptr<jobs::JobStatus> FileInfo::GetSaveStatus() const {
+	return m_savejob;
+}
+
+void FileInfo::StartSave(const std::string& destfile, const std::string& sourcefile, const bool overwrite, const bool inPlace, const bool backup) {
+	// Edits are only known relative to the last successful save into the loaded file.
+	// If that one is still running or failed the whole sheet gets written instead
+	const bool incremental = inPlace && (!m_inplacejob || m_inplacejob->GetState() == jobs::JOB_DONE);
+	SheetChanges changes;
+	// The worker gets its own copy of the rows, they only share the cell values with m_rowinfo
+	std::shared_ptr<const SheetRows> snapshot = CreateSheetRows(incremental ? &changes : nullptr);
+	// The edits now belong to the snapshot that gets saved, new edits are tracked from here on
+	if (inPlace)
+		ResetChanges();
+
+	std::shared_ptr<jobs::JobStatus> previous = m_savejob;
+	m_savejob = jobs::Submit("FileInfo::Save", [=, changes = std::move(changes)](jobs::JobStatus& status) {
+		// Saves of the same file have to be written in order
+		if (previous)
+			previous->Wait();
+		if (backup) {
+			status.SetStatusText("Backup");
+			BackupFile(destfile);
+		}
+		status.SetStatusText("Speichern");
+		return s_SaveExcelSheet(destfile, *snapshot, overwrite, sourcefile, incremental ? &changes : nullptr, &status);
+	}, false);
+	if (inPlace)
+		m_inplacejob = m_savejob;
 }
 
-void FileInfo::CreateSheetData() {
-	if (m_rowinfo.size() <= 0) {
-		return;	// no data to create
-	}
-	// Check if the sheetData is not even loaded
-	if (m_sheetData.size() <= 0) {
-		// Generate header row
+std::shared_ptr<const SheetRows> FileInfo::CreateSheetRows(SheetChanges* changes) {
+	// Files that were never loaded get a header row generated
+	if (m_templaterows->size() <= 0) {
 		std::vector<std::string> headerRow;
 		headerRow.push_back("DATA");
-		RowInfo tmp = m_rowinfo[0];
 		for (auto& header : GetHeaderNames()) {
 			const std::string fixedHeader = Splitlines(header, " ##").first;
 			headerRow.push_back(fixedHeader);
 		}
-		m_sheetData.push_back(headerRow);
+		m_templaterows = std::make_shared<const SheetData>(1, headerRow);
 		m_headeridx = 0;
 		for (auto& hinfo : m_headerinfo) {
 			hinfo.second.first = 0;
 		}
 	}
-	m_sheetData.resize(m_headeridx+1);	// Delete all data after the headers to overwrite them properly
-	size_t header_size = m_sheetData[m_headeridx].size();
-	// Generate all rows for m_sheetData
-	for (int x = 0; x < m_rowinfo.size(); x++) {
-		const RowInfo& ri = m_rowinfo[x];
-		auto&& rdata = ri.GetData();
-		// generate row
-		std::vector<std::string> rowinfo(m_headerinfo.size() + 1);
-		for (auto& pair : rdata) {
-			int header_x = -1, header_y = -1;
-			GetHeaderIndex(pair.first, &header_x, &header_y);
-			if (header_x != m_headeridx)
-				continue;
-			if (header_y <= 0)
+	std::unordered_map<std::string, int> columns;
+	for (auto& [header, index] : m_headerinfo) {
+		if (index.first == m_headeridx && index.second > 0)
+			columns.emplace(header, index.second);
+	}
+	if (changes) {
+		// Rows that did not move only get their edited values written, everything behind them was added or moved
+		const size_t dataStart = m_templaterows->size();
+		const size_t keep = std::min(m_savedrows, m_rowinfo.size());
+		for (size_t x = 0; x < keep; x++) {
+			const RowInfo& ri = m_rowinfo[x];
+			if (!ri.IsDirty())
 				continue;
-			rowinfo[header_y] = pair.second;
+			for (auto& pair : ri.GetDirtyData()) {
+				auto it = columns.find(pair.first);
+				if (it != columns.end())
+					changes->cells.push_back(std::make_pair(dataStart + x, static_cast<size_t>(it->second)));
+			}
 		}
-		m_sheetData.push_back(rowinfo);
+		changes->firstFullRow = dataStart + keep;
+	}
+	return std::make_shared<const SheetRows>(m_templaterows, m_rowinfo, std::move(columns));
+}
+
+void FileInfo::ResetChanges() {
+	for (RowInfo& ri : m_rowinfo) {
+		ri.ClearDirty();
 	}
+	m_savedrows = m_rowinfo.size();
 }
 
 std::string FileInfo::GetFilename() const {
@@ -908,20 +2243,32 @@ void FileInfo::GetHeaderIndex(const std::string& header, int* x, int* y) {
 	}
 }
 
-std::vector<std::string> FileInfo::GetHeaderNames() const {
-	std::vector<std::string> headernames;
-	for (auto& pair : m_headerinfo) {
-		headernames.push_back(pair.first);
-	}
-	return headernames;
+const std::vector<std::string>& FileInfo::GetHeaderNames() const {
+	return m_headernames;
 }
 
-std::vector<std::pair<std::string, std::pair<int, int>>> FileInfo::GetHeaderInfo(){
+const std::vector<std::pair<std::string, std::pair<int, int>>>& FileInfo::GetHeaderInfo() const {
 	return m_headerinfo;
 }
 
+const ColumnDictionary* FileInfo::GetDictionary(const std::string& header) const {
+	if (!m_layout)
+		return nullptr;
+	for (size_t x = 0; x < m_layout->headers.size() && x < m_layout->dictionaries.size(); x++) {
+		if (m_layout->headers[x] == header)
+			return m_layout->dictionaries[x].get();
+	}
+	return nullptr;
+}
+
 void FileInfo::SetHeaderInfo(std::vector<std::pair<std::string, std::pair<int, int>>> headerinfo){
-	m_headerinfo = headerinfo;
+	m_headerinfo = std::move(headerinfo);
+	m_headernames.clear();
+	for (auto& pair : m_headerinfo) {
+		m_headernames.push_back(pair.first);
+	}
+	m_columnstats.clear();
+	m_sortindex.clear();
 }
 
 RowInfo FileInfo::GetRowdata(const int rowIdx){
@@ -930,78 +2277,355 @@ RowInfo FileInfo::GetRowdata(const int rowIdx){
 	return m_rowinfo[rowIdx];
 }
 
-std::vector<RowInfo> FileInfo::GetData() {
+const std::vector<RowInfo>& FileInfo::GetData() const {
 	return m_rowinfo;
 }
 
 void RowInfo::Unload() {
-	m_rowinfo.clear();
+	m_layout.reset();
+	m_values.clear();
+	m_cells.clear();
+	m_owned.clear();
+	m_codes.clear();
+	m_dirty.clear();
 	m_changed = false;
 }
 
 void FileInfo::SetRowData(const RowInfo& rowinfo, const int rowIdx){
 	if (rowIdx >= m_rowinfo.size())
 		return;
-	m_rowinfo[rowIdx] = rowinfo;
+	const RowInfo& oldrow = m_rowinfo[rowIdx];
+	// rowinfo is mostly an edited copy, so keep track of everything that differs from the stored row
+	RowInfo updated = rowinfo;
+	updated.MergeDirty(oldrow);
+	// Only the statistics of columns that really changed have to be rebuilt
+	for (auto it = m_columnstats.begin(); it != m_columnstats.end();) {
+		if (oldrow.GetData(it->first) != rowinfo.GetData(it->first))
+			it = m_columnstats.erase(it);
+		else
+			++it;
+	}
+	// Sort orders just move the edited row to its new place
+	for (auto& [key, index] : m_sortindex) {
+		const std::string value = rowinfo.GetData(key.first);
+		if (oldrow.GetData(key.first) == value)
+			continue;
+		index.keys[rowIdx] = s_MakeSortKey(rowinfo, key.first);
+		s_ResortRow(index, rowIdx);
+	}
+	m_rowinfo[rowIdx] = std::move(updated);
+}
+
+void FileInfo::UpdateValue(const int rowIdx, const std::string& header, const std::string& value) {
+	if (rowIdx < 0 || rowIdx >= m_rowinfo.size())
+		return;
+	RowInfo& row = m_rowinfo[rowIdx];
+	row.UpdateData(header, value);
+	// Only the edited column has to be counted and sorted again
+	m_columnstats.erase(header);
+	for (auto& [key, index] : m_sortindex) {
+		if (key.first != header)
+			continue;
+		index.keys[rowIdx] = s_MakeSortKey(row, header);
+		s_ResortRow(index, rowIdx);
+	}
 }
 
 void FileInfo::AddRowData(const RowInfo& rowinfo){
 	m_rowinfo.push_back(rowinfo);
+	// Appending keeps the statistics valid, so just add the new values
+	for (auto& [header, stats] : m_columnstats) {
+		s_AddToColumnStats(stats, rowinfo, header);
+		stats.distinctEstimate = 0;
+	}
+	const int row = static_cast<int>(m_rowinfo.size()) - 1;
+	for (auto& [key, index] : m_sortindex) {
+		index.keys.push_back(s_MakeSortKey(rowinfo, key.first));
+		s_ResortRow(index, row);
+	}
 }
 
 void FileInfo::RemoveData(const int rowIdx){
 	if (rowIdx >= m_rowinfo.size())
 		return;
 	m_rowinfo.erase(m_rowinfo.begin() + rowIdx);
+	m_savedrows = std::min(m_savedrows, static_cast<size_t>(rowIdx));	// Every row behind moved up by one
+	m_columnstats.clear();	// min, max and distinct values cannot be taken back
+	// Drop the row from every sort order and shift the indexes behind it
+	for (auto& [key, index] : m_sortindex) {
+		index.order.erase(std::find(index.order.begin(), index.order.end(), rowIdx));
+		for (int& row : index.order) {
+			if (row > rowIdx)
+				row--;
+		}
+		index.keys.erase(index.keys.begin() + rowIdx);
+	}
 }
 
 void FileInfo::ClearData(){
 	m_rowinfo.clear();
+	m_savedrows = 0;
+	m_columnstats.clear();
+	m_sortindex.clear();
 }
 
 bool FileInfo::IsReady() const{
 	return m_isready;
 }
 
+uint32_t ColumnDictionary::Add(const std::string& value) {
+	auto it = m_codes.find(value);
+	if (it != m_codes.end())
+		return it->second;
+	const uint32_t code = static_cast<uint32_t>(m_values.size());
+	m_values.push_back(value);
+	m_codes.emplace(m_values.back(), code);
+	return code;
+}
+
+uint32_t ColumnDictionary::Find(const std::string& value) const {
+	auto it = m_codes.find(value);
+	return it != m_codes.end() ? it->second : NO_CODE;
+}
+
+const std::string& ColumnDictionary::GetValue(const uint32_t code) const {
+	return m_values[code];
+}
+
+size_t ColumnDictionary::Size() const {
+	return m_values.size();
+}
+
+void CellArena::Reserve(const size_t bytes) {
+	if (bytes <= m_left)
+		return;
+	m_blocks.push_back(std::make_unique_for_overwrite<char[]>(bytes));
+	m_next = m_blocks.back().get();
+	m_left = bytes;
+}
+
+std::string_view CellArena::Store(const std::string_view value) {
+	if (value.empty())
+		return {};
+	if (value.size() > m_left)
+		Reserve(std::max(value.size(), BLOCK_SIZE));
+	char* data = m_next;
+	std::memcpy(data, value.data(), value.size());
+	m_next += value.size();
+	m_left -= value.size();
+	m_size += value.size();
+	return std::string_view(data, value.size());
+}
+
+size_t CellArena::Size() const {
+	return m_size;
+}
+
+RowInfo::RowInfo(const std::shared_ptr<RowLayout>& layout) : m_layout(layout) {
+	const size_t count = layout ? layout->headers.size() : 0;
+	m_values.resize(count);
+	m_cells.resize(count);
+	m_codes.assign(count, ColumnDictionary::NO_CODE);
+	m_dirty.assign(count, false);
+}
+
+int RowInfo::FindHeader(const std::string& header) const {
+	if (!m_layout)
+		return -1;
+	const auto& headers = m_layout->headers;
+	for (size_t x = 0; x < m_values.size() && x < headers.size(); x++) {
+		if (headers[x] == header)
+			return static_cast<int>(x);
+	}
+	return -1;
+}
+
+size_t RowInfo::Size() const {
+	return m_values.size();
+}
+
+std::string RowInfo::GetValue(const size_t x) const {
+	// Numbers and dates only keep their text if formatting would change it or they are encoded
+	return m_values[x].empty() ? FormatCell(m_cells[x]) : std::string(m_values[x]);
+}
+
+void RowInfo::GetValue(const size_t x, std::string& out) const {
+	if (m_values[x].empty())
+		out = FormatCell(m_cells[x]);
+	else
+		out.assign(m_values[x].data(), m_values[x].size());
+}
+
+const Cell& RowInfo::GetCell(const size_t x) const {
+	return m_cells[x];
+}
+
+const RowLayout* RowInfo::GetLayout() const {
+	return m_layout.get();
+}
+
+void RowInfo::SetOwnedValue(const size_t x, const std::string& value) {
+	auto it = std::find_if(m_owned.begin(), m_owned.end(), [x](const auto& owned) { return owned.first == x; });
+	if (value.empty()) {
+		m_values[x] = {};
+		if (it != m_owned.end())
+			m_owned.erase(it);
+		return;
+	}
+	// A new string is owned each time, copies of this row might still point to the previous one
+	auto owned = std::make_shared<const std::string>(value);
+	m_values[x] = *owned;
+	if (it != m_owned.end())
+		it->second = std::move(owned);
+	else
+		m_owned.emplace_back(x, std::move(owned));
+}
+
+void RowInfo::SetValue(const size_t x, const std::string& value) {
+	// Edited dates are only typed if they are written as dd.mm.yyyy, so numbers stay numbers while they are typed
+	const bool dateColumn = x < m_layout->dates.size() && m_layout->dates[x];
+	m_cells[x] = ParseCell(value);
+	if (dateColumn && m_cells[x].type == CELL_TEXT)
+		m_cells[x] = ParseDateCell(value);
+	// Values that are part of the dictionary of the column only store their code
+	const ColumnDictionary* dictionary = x < m_layout->dictionaries.size() ? m_layout->dictionaries[x].get() : nullptr;
+	const uint32_t code = dictionary ? dictionary->Find(value) : ColumnDictionary::NO_CODE;
+	m_codes[x] = code;
+	if (code != ColumnDictionary::NO_CODE) {
+		SetOwnedValue(x, "");
+		m_values[x] = dictionary->GetValue(code);
+	}
+	else if (!KeepsCellText(m_cells[x], value))
+		SetOwnedValue(x, "");
+	else
+		SetOwnedValue(x, value);
+}
+
+void RowInfo::StoreValue(const size_t x, const std::string& value) {
+	const bool dateColumn = x < m_layout->dates.size() && m_layout->dates[x];
+	m_cells[x] = dateColumn ? ParseDateCell(value) : ParseCell(value);
+	const ColumnDictionary* dictionary = x < m_layout->dictionaries.size() ? m_layout->dictionaries[x].get() : nullptr;
+	const uint32_t code = dictionary ? dictionary->Find(value) : ColumnDictionary::NO_CODE;
+	m_codes[x] = code;
+	if (code != ColumnDictionary::NO_CODE)
+		m_values[x] = dictionary->GetValue(code);
+	else if (!KeepsCellText(m_cells[x], value))
+		m_values[x] = {};
+	else if (m_layout->arena)
+		m_values[x] = m_layout->arena->Store(value);
+	else
+		SetOwnedValue(x, value);
+}
+
+uint64_t NewLayoutGeneration() {
+	static std::atomic<uint64_t> generation = 0;
+	return ++generation;
+}
+
 void RowInfo::AddData(const std::string& header, const std::string& value){
-	auto it = std::find_if(m_rowinfo.begin(), m_rowinfo.end(),
-		[&header](const std::pair<std::string, std::string>& p) {
-			return p.first == header;
-		});
+	const int x = FindHeader(header);
 	// Only add it if the header does not exist else edit the value
-	if (it == m_rowinfo.end()) {
-		m_rowinfo.push_back(std::make_pair(header, value));
+	if (x >= 0) {
+		SetValue(x, value);
 		return;
 	}
-	it->second = value;
+	// The layout is shared with the other rows of the file, so it gets its own copy before a header is added
+	if (!m_layout)
+		m_layout = std::make_shared<RowLayout>();
+	else if (m_layout.use_count() > 1 || m_layout->headers.size() != m_values.size())
+		m_layout = std::make_shared<RowLayout>(*m_layout);
+	m_layout->headers.resize(m_values.size());
+	m_layout->dictionaries.resize(m_values.size());
+	m_layout->dates.resize(m_values.size(), false);
+	m_layout->headers.push_back(header);
+	m_layout->dictionaries.push_back(nullptr);
+	m_layout->dates.push_back(false);
+	m_layout->generation = NewLayoutGeneration();
+	m_values.emplace_back();
+	m_cells.emplace_back();
+	m_codes.push_back(ColumnDictionary::NO_CODE);
+	m_dirty.push_back(false);
+	SetValue(m_values.size() - 1, value);
 }
 
 void RowInfo::UpdateData(const std::string& header, const std::string& newValue){
-	auto it = std::find_if(m_rowinfo.begin(), m_rowinfo.end(),
-		[&header](const std::pair<std::string, std::string>& p) {
-			return p.first == header;
-		});
-	if (it == m_rowinfo.end()) {
+	const int x = FindHeader(header);
+	if (x < 0) {
 		return;	// Header is not present, so dont update
 	}
-	it->second = newValue;
+	SetValue(x, newValue);
+	m_dirty.resize(m_values.size(), false);
+	m_dirty[x] = true;
 	m_changed = true;
 }
 
 std::string RowInfo::GetData(const std::string& header) const{
-	for (auto& p : m_rowinfo) {
-		if (p.first == header)
-			return p.second;
-	}
+	const int x = FindHeader(header);
+	if (x >= 0)
+		return GetValue(x);
 	return "";	// header does not exit return empty
 }
 
+const Cell* RowInfo::GetCell(const std::string& header) const {
+	const int x = FindHeader(header);
+	return x >= 0 ? &m_cells[x] : nullptr;
+}
+
+bool RowInfo::GetNumber(const std::string& header, double& out) const {
+	const int x = FindHeader(header);
+	if (x < 0)
+		return false;
+	const Cell& cell = m_cells[x];
+	if (cell.type == CELL_INTEGER) {
+		out = static_cast<double>(cell.integer);
+		return true;
+	}
+	if (cell.type == CELL_NUMBER) {
+		out = cell.number;
+		return true;
+	}
+	// Text can still be a number that was not typed to keep its text, like "007" or "3.5"
+	return cell.type == CELL_TEXT && StrToNumber(std::string(m_values[x]), out);
+}
+
+uint32_t RowInfo::GetCode(const std::string& header, const ColumnDictionary* dictionary) const {
+	const int x = FindHeader(header);
+	if (x < 0 || dictionary == nullptr || x >= m_layout->dictionaries.size() || m_layout->dictionaries[x].get() != dictionary)
+		return ColumnDictionary::NO_CODE;
+	return m_codes[x];
+}
+
 std::vector<std::pair<std::string, std::string>> RowInfo::GetData() const{
-	return m_rowinfo;
+	std::vector<std::pair<std::string, std::string>> data;
+	data.reserve(m_values.size());
+	for (size_t x = 0; x < m_values.size(); x++) {
+		data.emplace_back(m_layout->headers[x], GetValue(x));
+	}
+	return data;
 }
 
 void RowInfo::SetData(const std::vector<std::pair<std::string, std::string>>& data){
-	m_rowinfo = data;
+	// The same headers in the same order keep the shared layout and with it the dictionaries
+	bool sameHeaders = m_layout && data.size() == m_values.size();
+	for (size_t x = 0; sameHeaders && x < data.size(); x++) {
+		sameHeaders = m_layout->headers[x] == data[x].first;
+	}
+	if (!sameHeaders) {
+		m_layout = std::make_shared<RowLayout>();
+		for (auto& pair : data) {
+			m_layout->headers.push_back(pair.first);
+		}
+		m_layout->dictionaries.resize(data.size());
+		m_layout->dates.resize(data.size(), false);
+		m_values.assign(data.size(), {});
+		m_cells.assign(data.size(), Cell());
+		m_owned.clear();
+		m_codes.assign(data.size(), ColumnDictionary::NO_CODE);
+	}
+	for (size_t x = 0; x < data.size(); x++) {
+		SetValue(x, data[x].second);
+	}
+	m_dirty.assign(m_values.size(), true);
 }
 
 bool RowInfo::Changed() {
@@ -1014,6 +2638,59 @@ void RowInfo::ResetChanged() {
 	m_changed = false;
 }
 
+bool RowInfo::IsDirty() const {
+	return std::find(m_dirty.begin(), m_dirty.end(), true) != m_dirty.end();
+}
+
+std::vector<std::pair<std::string, std::string>> RowInfo::GetDirtyData() const {
+	std::vector<std::pair<std::string, std::string>> dirtyData;
+	for (size_t x = 0; x < m_dirty.size() && x < m_values.size(); x++) {
+		if (m_dirty[x])
+			dirtyData.emplace_back(m_layout->headers[x], GetValue(x));
+	}
+	return dirtyData;
+}
+
+void RowInfo::MergeDirty(const RowInfo& previous) {
+	m_dirty.resize(m_values.size(), false);
+	for (size_t x = 0; x < m_values.size(); x++) {
+		if (m_dirty[x])
+			continue;
+		const std::string& header = m_layout->headers[x];
+		// Both rows share the same header order most of the time
+		int prevIdx = -1;
+		if (x < previous.m_values.size() && previous.m_layout->headers[x] == header)
+			prevIdx = static_cast<int>(x);
+		else
+			prevIdx = previous.FindHeader(header);
+		if (prevIdx < 0) {
+			m_dirty[x] = true;
+			continue;
+		}
+		const bool wasDirty = prevIdx < previous.m_dirty.size() && previous.m_dirty[prevIdx];
+		// Codes of the same dictionary only match if the values do
+		const bool sameDictionary = m_codes[x] != ColumnDictionary::NO_CODE && previous.m_codes[prevIdx] != ColumnDictionary::NO_CODE
+			&& m_layout->dictionaries[x] == previous.m_layout->dictionaries[prevIdx];
+		// Typed values compare by their number, text by its bytes
+		const Cell& cell = m_cells[x];
+		const Cell& prevCell = previous.m_cells[prevIdx];
+		bool changed = cell.type != prevCell.type;
+		if (sameDictionary)
+			changed = m_codes[x] != previous.m_codes[prevIdx];
+		else if (!changed && cell.type == CELL_INTEGER)
+			changed = cell.integer != prevCell.integer;
+		else if (!changed && IsNumericCell(cell))
+			changed = cell.number != prevCell.number;
+		else if (!changed)
+			changed = m_values[x] != previous.m_values[prevIdx];
+		m_dirty[x] = wasDirty || changed;
+	}
+}
+
+void RowInfo::ClearDirty() {
+	m_dirty.assign(m_values.size(), false);
+}
+
 void FileSettings::Unload() {
 	m_parentFile = nullptr;
 	if(m_mergefileSet)
@@ -1026,9 +2703,12 @@ void FileSettings::Unload() {
 	m_mergefolder = "";
 	m_mergefolderSet = false;
 	m_mergefolderpaths.clear();
+	m_mergefoldercache.clear();
+	m_mergefolderwatch.reset();
+	m_mergefolderignorecache = false;
 }
 
-void FileSettings::SetMergeFile(const FileInfo otherFile) {
+void FileSettings::SetMergeFile(FileInfo otherFile) {
 	if (!m_parentFile) {
 		logging::logwarning("FILELOADER::FileSettings::SetMergeFile m_parentFile is currently not set!");
 		return;
@@ -1037,11 +2717,11 @@ void FileSettings::SetMergeFile(const FileInfo otherFile) {
 		logging::logwarning("FILELOADER::FileSettings::SetMergeFile Given File is not a valid file.\n%s", otherFile.GetFilename());
 		return;
 	}
-	m_mergefile = otherFile;
+	m_mergefile = std::move(otherFile);
 	m_mergefileSet = true;
 }
 
-FileInfo FileSettings::GetMergeFile() const {
+const FileInfo& FileSettings::GetMergeFile() const {
 	return m_mergefile;
 }
 
@@ -1102,7 +2782,48 @@ std::vector<std::pair<std::string, std::string>> FileSettings::GetMergeHeaders()
 	return m_mergeheaders;
 }
 
+// Maps every key value of header to the first row that holds it, the column statistics tell how big it gets
+static std::unordered_map<std::string, size_t> s_BuildMergeIndex(FileInfo& file, const std::vector<RowInfo>& rows, const std::string& header) {
+	std::unordered_map<std::string, size_t> index;
+	const ColumnStats& stats = file.GetColumnStats(header);
+	if (stats.emptyCount == stats.rows)
+		return index;	// No keys at all, nothing can be merged
+	index.reserve(stats.distinctEstimate);
+	for (size_t x = 0; x < rows.size(); x++) {
+		std::string value = rows[x].GetData(header);
+		if (value == "")
+			continue;
+		index.emplace(std::move(value), x);	// emplace keeps the first match like a linear search would
+	}
+	return index;
+}
+
+static constexpr int s_unknownKey = -2;	// Key code that was not looked up yet
+
+// Returns the merge row matching the key of row or -1 and sets value to the key. Keys of a dictionary encoded column
+// are only looked up once per distinct value, all further rows find the result by their code inside keyRows
+static int s_FindMergeRow(const std::unordered_map<std::string, size_t>& index, const RowInfo& row, const std::string& header,
+	const ColumnDictionary* dictionary, std::vector<int>& keyRows, std::string& value) {
+	const uint32_t code = row.GetCode(header, dictionary);
+	if (code != ColumnDictionary::NO_CODE && keyRows[code] != s_unknownKey) {
+		if (keyRows[code] >= 0)
+			value = dictionary->GetValue(code);
+		return keyRows[code];
+	}
+	value = row.GetData(header);
+	int found = -1;
+	if (value != "") {
+		auto it = index.find(value);
+		if (it != index.end())
+			found = static_cast<int>(it->second);
+	}
+	if (code != ColumnDictionary::NO_CODE)
+		keyRows[code] = found;
+	return found;
+}
+
 void FileSettings::MergeFiles() {
+	UpdateMergeFolder();
 	std::unordered_set<std::string> dontimportvalues;	// Set to check for the condition header to NOT import
 	if (m_dontimportifexistsheader != "" && m_dontimportifexistsheader != "NONE") {
 		for (auto& finfo : m_parentFile->GetData()) {
@@ -1119,8 +2840,8 @@ void FileSettings::MergeFiles() {
 		if (!cachefile) {
 			logging::logwarning("FILELOADER::FileSettings::MergeFiles cannot cache filedata!\n%s", cache);
 		}
-		// Now comes the merging magic. maybe this can be optimized later on
-		std::vector<RowInfo>&& data = m_parentFile->GetData();
+		// Now comes the merging magic. The rows get edited, so this works on a copy of them
+		std::vector<RowInfo> data = m_parentFile->GetData();
 		size_t dataSize = data.size();
 		if (data.size() <= 0) {
 			RowInfo emptyRow;
@@ -1129,6 +2850,7 @@ void FileSettings::MergeFiles() {
 			}
 			data.push_back(emptyRow);
 		}
+		std::vector<std::string> merged;
 		for (auto& path : m_mergefolderpaths) {
 			FileInfo file;
 			file.LoadFile(path);
@@ -1137,9 +2859,12 @@ void FileSettings::MergeFiles() {
 			}
 			if (cachefile) {
 				fs::path filep = fs::u8path(path);
-				cachefile << path << " : " << GetLastWriteTime(filep) << "\n";
+				const std::string writeTime = GetLastWriteTime(filep);
+				cachefile << path << " : " << writeTime << "\n";
+				m_mergefoldercache[path] = writeTime;
+				merged.push_back(path);
 			}
-			std::vector<RowInfo>&& mergeData = file.GetData();
+			const std::vector<RowInfo>& mergeData = file.GetData();
 			if (m_mergefolderif.first == "") {
 				for (auto& row : mergeData) {
 					if (dontimportvalues.size() > 0) {
@@ -1171,27 +2896,26 @@ void FileSettings::MergeFiles() {
 				}
 			}
 			else {
+				const auto mergeIndex = s_BuildMergeIndex(file, mergeData, m_mergefolderif.second);
+				const ColumnDictionary* keyDictionary = m_parentFile->GetDictionary(m_mergefolderif.first);
+				std::vector<int> keyRows(keyDictionary ? keyDictionary->Size() : 0, s_unknownKey);
 				int idx = -1;
 				for (auto& row : data) {
 					idx++;
-					std::string value = row.GetData(m_mergefolderif.first);
-					if (value == "")
+					if (mergeIndex.empty())
+						break;
+					std::string value;
+					const int found = s_FindMergeRow(mergeIndex, row, m_mergefolderif.first, keyDictionary, keyRows, value);
+					if (found < 0)
 						continue;
-					for (auto& merge_row : mergeData) {
-						std::string merge_value = merge_row.GetData(m_mergefolderif.second);
-						if (merge_value == "")
-							continue;
-						if (merge_value != value)
-							continue;
-						for (auto& pair : m_mergeheadersfolder) {
-							std::string new_val = merge_row.GetData(pair.second);
-							if (new_val != "" && value != new_val) {
+					const RowInfo& merge_row = mergeData[found];
+					for (auto& pair : m_mergeheadersfolder) {
+						std::string new_val = merge_row.GetData(pair.second);
+						if (new_val != "" && value != new_val) {
 
-								row.UpdateData(pair.first, new_val);
-								cellsImported++;
-							}
+							row.UpdateData(pair.first, new_val);
+							cellsImported++;
 						}
-						break;
 					}
 					if (row.Changed()) {
 						m_parentFile->SetRowData(row, idx);
@@ -1200,12 +2924,15 @@ void FileSettings::MergeFiles() {
 			}
 			file.Unload();
 		}
-		SetMergeFolder(m_mergefolder);
+		// Cached files are done, files that failed stay to merge and changes are picked up by the watcher
+		for (const std::string& path : merged) {
+			m_mergefolderpaths.erase(path);
+		}
 	}
 	if (!m_mergefile.IsReady())
 		return;
 	logging::loginfo("FILELOADER::FileSettings::MergeFiles Merging files\n\t%s\n\t%s\n\t And Searching for header: %s to fill with %s", m_parentFile->GetFilename().c_str(), m_mergefile.GetFilename().c_str(), m_mergeif.first.c_str(), m_mergeif.second.c_str());
-	std::vector<RowInfo> &&data = m_parentFile->GetData();
+	std::vector<RowInfo> data = m_parentFile->GetData();	// The rows get edited, so this works on a copy of them
 	if (data.size() <= 0) {
 		RowInfo emptyRow;
 		for (auto& header : m_parentFile->GetHeaderNames()) {
@@ -1213,27 +2940,26 @@ void FileSettings::MergeFiles() {
 		}
 		data.push_back(emptyRow);
 	}
-	std::vector<RowInfo> &&mergeData = m_mergefile.GetData();
+	const std::vector<RowInfo>& mergeData = m_mergefile.GetData();
+	const auto mergeIndex = s_BuildMergeIndex(m_mergefile, mergeData, m_mergeif.second);
+	const ColumnDictionary* keyDictionary = m_parentFile->GetDictionary(m_mergeif.first);
+	std::vector<int> keyRows(keyDictionary ? keyDictionary->Size() : 0, s_unknownKey);
 	int idx = -1;
 	for (auto& row : data) {
 		idx++;
-		std::string value = row.GetData(m_mergeif.first);
-		if (value == "")
+		if (mergeIndex.empty())
+			break;
+		std::string value;
+		const int found = s_FindMergeRow(mergeIndex, row, m_mergeif.first, keyDictionary, keyRows, value);
+		if (found < 0)
 			continue;
-		for (auto& merge_row : mergeData) {
-			std::string merge_value = merge_row.GetData(m_mergeif.second);
-			if (merge_value == "")
-				continue;
-			if (merge_value != value)
-				continue;
-			for (auto& pair : m_mergeheaders) {
-				std::string new_val = merge_row.GetData(pair.second);
-				if (new_val != "" && new_val != value) {
-					row.UpdateData(pair.first, new_val);
-					cellsImported++;
-				}
+		const RowInfo& merge_row = mergeData[found];
+		for (auto& pair : m_mergeheaders) {
+			std::string new_val = merge_row.GetData(pair.second);
+			if (new_val != "" && new_val != value) {
+				row.UpdateData(pair.first, new_val);
+				cellsImported++;
 			}
-			break;
 		}
 		if (row.Changed()) {
 			m_parentFile->SetRowData(row, idx);
@@ -1242,9 +2968,29 @@ void FileSettings::MergeFiles() {
 	logging::loginfo("FILELOADER::FileSettings::MergeFiles %d Cells merged", cellsImported);
 }
 
+// Files inside a merge folder that can be merged
+static bool s_IsMergeFolderFile(const fs::path& path) {
+	const std::string extension = path.extension().string();
+	return extension == ".csv" || extension == ".CSV" || extension == ".xlsx" || extension == ".XLSX";
+}
+
+// Path of a merge folder file the way it is stored in m_mergefolderpaths and the .cache file
+static std::string s_MergeFolderPath(const fs::path& path) {
+	std::u8string u8str = path.u8string();
+	std::string strpath = std::string(u8str.begin(), u8str.end());
+	for (auto& c : strpath) {
+		if (c == '\\')
+			c = '/';
+	}
+	return strpath;
+}
+
 void FileSettings::SetMergeFolder(const std::string& folder, const bool ignoreCache) {
 	fs::path path = fs::u8path(folder);
 	m_mergefolderpaths.clear();
+	m_mergefoldercache.clear();
+	m_mergefolderwatch.reset();
+	m_mergefolderignorecache = ignoreCache;
 
 	if (!m_parentFile) {
 		logging::logerror("FILELOADER::FileSettings::SetMergeFolder Parent File is not setup!");
@@ -1260,38 +3006,24 @@ void FileSettings::SetMergeFolder(const std::string& folder, const bool ignoreCa
 		std::string cache = folder + "/.cache";
 		fs::path cachepath = fs::u8path(cache);
 		std::ifstream cachefile(cachepath.wstring(), std::ios::binary);
-		std::vector<std::pair<std::string, std::string>> cachedData;
-		std::vector<std::string> newcache;
-		if (!ignoreCache && cachefile) {
+		// The cache is kept either way, so later changes can be checked against it without reading it again
+		if (cachefile) {
 			std::string line;
 			while (std::getline(cachefile, line)) {
 				RemoveAllSubstrings(line, "\n");
 				std::pair<std::string, std::string> values = Splitlines(line, " : ");
-				cachedData.push_back(values);
+				m_mergefoldercache[values.first] = values.second;	// later lines are newer
 			}
 		}
+		// Changes from now on are applied by UpdateMergeFolder, so this is the only full scan
+		m_mergefolderwatch = watcher::Watch(path);
 		// iterate each file and check for its ending to be a valid file
 		for (const auto& entry : fs::directory_iterator(path)) {
-			if (entry.is_regular_file()
-				&& (entry.path().extension().string() == ".csv"
-					|| entry.path().extension().string() == ".CSV"
-					|| entry.path().extension().string() == ".xlsx"
-					|| entry.path().extension().string() == ".XLSX")) {
-				std::u8string u8str = entry.path().u8string();
-				std::string strpath = std::string(u8str.begin(), u8str.end());
-				for (auto& c : strpath) {
-					if (c == '\\')
-						c = '/';
-				}
-				bool add = true;
-				for (auto& pair : cachedData) {
-					// Dont add the file if the last writetime is same as in .cache
-					if (pair.first == strpath && pair.second == GetLastWriteTime(entry.path())) {
-						add = false;
-						break;
-					}
-				}
-				if (!add)
+			if (entry.is_regular_file() && s_IsMergeFolderFile(entry.path())) {
+				const std::string strpath = s_MergeFolderPath(entry.path());
+				// Dont add the file if the last writetime is same as in .cache
+				auto cached = m_mergefoldercache.find(strpath);
+				if (!ignoreCache && cached != m_mergefoldercache.end() && cached->second == GetLastWriteTime(entry.path()))
 					continue;
 				m_mergefolderpaths.insert(strpath);
 			}
@@ -1311,6 +3043,35 @@ void FileSettings::SetMergeFolder(const std::string& folder, const bool ignoreCa
 	m_mergefolderSet = true;
 }
 
+void FileSettings::UpdateMergeFolder() {
+	if (!m_mergefolderSet || !m_mergefolderwatch)
+		return;
+	// Events got lost, so only a full scan is reliable
+	if (m_mergefolderwatch->TakeOverflow()) {
+		m_mergefolderwatch->TakeChanges();
+		SetMergeFolder(m_mergefolder, m_mergefolderignorecache);
+		return;
+	}
+	for (const fs::path& changed : m_mergefolderwatch->TakeChanges()) {
+		const std::string strpath = s_MergeFolderPath(changed);
+		try {
+			if (!s_IsMergeFolderFile(changed) || !fs::is_regular_file(changed)) {
+				m_mergefolderpaths.erase(strpath);
+				continue;
+			}
+			auto cached = m_mergefoldercache.find(strpath);
+			if (m_mergefolderignorecache || cached == m_mergefoldercache.end() || cached->second != GetLastWriteTime(changed))
+				m_mergefolderpaths.insert(strpath);
+			else
+				m_mergefolderpaths.erase(strpath);
+		}
+		catch (const std::exception& e) {
+			// The file is already gone again
+			m_mergefolderpaths.erase(strpath);
+		}
+	}
+}
+
 std::string FileSettings::GetMergeFolder() const{
 	return m_mergefolder;
 }
@@ -1319,7 +3080,7 @@ bool FileSettings::IsMergeFolderSet() const{
 	return m_mergefolderSet;
 }
 
-std::unordered_set<std::string> FileSettings::GetMergeFolderPaths() const {
+const std::unordered_set<std::string>& FileSettings::GetMergeFolderPaths() const {
 	return m_mergefolderpaths;
 }
 
@@ -1342,7 +3103,7 @@ void FileSettings::SetMergeFolderTemplate(const std::string& filepath) {
 	m_mergefolderfileSet = true;
 }
 
-FileInfo FileSettings::GetMergeFolderTemplate() const{
+const FileInfo& FileSettings::GetMergeFolderTemplate() const{
 	return m_mergefolderfile;
 }
 
@@ -28,31 +28,92 @@ SOFTWARE.
 #include <vector>
 #include <xlnt/xlnt.hpp>
 #include <unordered_set>
-// Splits all worksheets into separate .xlsx files
-void SplitWorksheets(const std::string& filename, const std::string& outdir = "sheets/", const int startindex = 0);
-void ExportWorksheets(const std::string& filename, const std::vector<std::string> sheetnames, const std::string& outdir = "sheets/", const int startindex = 0);
-void EditWorksheet(const std::string& filename, int DATA_row = 0, bool deleteEmptyRows = true);
+#include <unordered_map>
+#include <map>
+#include <deque>
+#include <string_view>
+#include <cstdint>
+#include <memory>
+#include <filesystem>
+#include "jobs.h"
+#include "watcher.h"
+#include "cell.h"
+// Splits all worksheets into separate .xlsx files, returns false if any of them failed
+bool SplitWorksheets(const std::string& filename, const std::string& outdir = "sheets/", const int startindex = 0);
+bool ExportWorksheets(const std::string& filename, const std::vector<std::string> sheetnames, const std::string& outdir = "sheets/", const int startindex = 0);
+// Names of all worksheets in workbook order, the cells are not loaded
+std::vector<std::string> GetWorksheetNames(const std::string& filename);
+bool EditWorksheet(const std::string& filename, int DATA_row = 0, bool deleteEmptyRows = true);
 void BackupFile(const std::string& filename);
+// Replaces filename with the given backup of it
+void RestoreBackup(const std::filesystem::path& backupfile, const std::filesystem::path& filename);
 void EnableTimings();
 void DisableTimings();
 bool IsTimings();
+// Parses filename on a worker into the file cache, so loading it afterwards does not parse it again.
+// snapshotfile is used the same way as in FileInfo::LoadFile
+void PrefetchFile(const std::string& filename, const std::string& snapshotfile = "");
+// Memory in bytes the parsed files inside the file cache may use, the least recently used ones are dropped first
+void SetFileCacheBudget(const size_t bytes);
+void ClearFileCache();
+// Drops filename from the file cache, it is parsed again the next time it is loaded
+void InvalidateCachedFile(const std::string& filename);
 
 // Class predefinitions
 class RowInfo;
+struct RowLayout;
+class ColumnDictionary;
+class CellArena;
+class SheetRows;
 class FileSettings;
 class FileInfo;
 
+// Statistics of a single column, computed lazily by FileInfo::GetColumnStats
+struct ColumnStats {
+	size_t rows = 0;							// Rows the statistics were built from
+	size_t emptyCount = 0;				// Rows without a value in this column
+	size_t numericCount = 0;			// Values that are numbers, min/max/sum only cover these
+	double min = 0.0;
+	double max = 0.0;
+	double sum = 0.0;
+	size_t distinctEstimate = 0;	// Estimated count of distinct non empty values
+	std::vector<uint8_t> registers;	// HyperLogLog registers the estimate is built from
+};
+
+// Sort key of a single cell, numbers and dd.mm.yyyy dates compare by value and everything else as text
+struct SortKey {
+	int kind = 0;					// 0 = number or date, 1 = text, 2 = empty (always sorted last)
+	double number = 0.0;
+	std::string text;
+};
+
+// Cells of the sheet data that changed since the file was loaded or saved
+struct SheetChanges {
+	std::vector<std::pair<size_t, size_t>> cells;	// Row and column inside the sheet data
+	size_t firstFullRow = 0;	// Every row starting at this one has to be written completely
+};
+
+// Cached row order of one header and direction, keys are stored by row index
+struct SortIndex {
+	std::vector<int> order;
+	std::vector<SortKey> keys;
+	bool ascending = true;
+};
+
 // FileInfo stores all data related to a excel file that can be loaded
 class FileInfo {
 public:
-	// Load a file with given filename
-	void LoadFile(const std::string& filename);
-	// Save the loaded data to given filename
+	// Load a file with given filename, if a snapshotfile is given the file is read from it while
+	// the file is unchanged and the snapshot gets written after parsing otherwise.
+	// With cache the parsed sheet stays in the file cache, that is meant for project files only
+	void LoadFile(const std::string& filename, const std::string& snapshotfile = "", const bool cache = false);
+	// Save the loaded data to given filename, the file is written in the background
 	void SaveFile(const std::string& filename = "");
-	// Saves the loaded file as a given destfile and tries to load sourcefile if there is any
-	void SaveFileAs(const std::string& sourcefile, const std::string& destfile);
-	// Converts all RowInfo inside m_rowinfo into m_sheetData
-	void CreateSheetData();
+	// Saves the loaded file as a given destfile and tries to load sourcefile if there is any.
+	// The file is written in the background and backed up before if backup is set
+	void SaveFileAs(const std::string& sourcefile, const std::string& destfile, const bool backup = false);
+	// Status of the last save that was started, nullptr if there was none
+	std::shared_ptr<jobs::JobStatus> GetSaveStatus() const;
 	// Returns the filename
 	std::string GetFilename() const;
 	
@@ -61,24 +122,38 @@ public:
 	// Get the index of a given header as integers that are provided
 	void GetHeaderIndex(const std::string& header, int* x, int* y);
 	// Get the vector of all header names
-	std::vector<std::string> GetHeaderNames() const;
-	// Get whole headerinfo with information about header indexes inside m_sheetData
-	std::vector<std::pair<std::string, std::pair<int, int>>> GetHeaderInfo();
-	// Sets a header with info of given index inside m_sheetData
+	const std::vector<std::string>& GetHeaderNames() const;
+	// Dictionary of a header if its values were encoded when loading, nullptr otherwise
+	const ColumnDictionary* GetDictionary(const std::string& header) const;
+	// Get whole headerinfo with information about header indexes inside the sheet
+	const std::vector<std::pair<std::string, std::pair<int, int>>>& GetHeaderInfo() const;
+	// Sets a header with info of given index inside the sheet, pass an rvalue to move it in
 	void SetHeaderInfo(std::vector<std::pair<std::string, std::pair<int, int>>> headerinfo);
 	
-	// Gets the rowdate inside m_sheetData at given index
+	// Gets the rowdata at given index
 	RowInfo GetRowdata(const int rowIdx);
-	// Gets the whole RowInfo data loaded
-	std::vector<RowInfo> GetData();
+	// Gets the whole RowInfo data loaded, copy a row to edit it and write it back with SetRowData
+	const std::vector<RowInfo>& GetData() const;
 	// Sets the RowInfo at a given row index
 	void SetRowData(const RowInfo& rowinfo, const int rowIdx);
+	// Sets a single value of the row at given row index, the row is edited where it is stored
+	void UpdateValue(const int rowIdx, const std::string& header, const std::string& value);
 	// Adds RowInfo to the dataset
 	void AddRowData(const RowInfo& rowinfo);
 	// Removes RowInfo at given row index
 	void RemoveData(const int rowIdx);
 	// Clear all data
 	void ClearData();
+
+	// Get the statistics of a header, they are computed on first use and kept until the column is edited
+	const ColumnStats& GetColumnStats(const std::string& header);
+	// Drops the cached statistics of a header or of all headers if header is empty
+	void InvalidateColumnStats(const std::string& header = "");
+	// Get the row indexes ordered by the values of header, the order is cached per header and direction
+	const std::vector<int>& GetSortedIndex(const std::string& header, const bool ascending = true);
+	// Groups all rows by the values of groupHeaders and counts them, valueHeaders get summed and averaged.
+	// The result is written into result as a new in memory file that can be displayed or saved
+	void Aggregate(const std::vector<std::string>& groupHeaders, const std::vector<std::string>& valueHeaders, FileInfo& result) const;
 	
 	// Returns if the fileInfo is read (file loaded)
 	bool IsReady() const;
@@ -94,25 +169,100 @@ public:
 	FileSettings *Settings;
 
 private:
+	// Snapshots the rows and writes them to destfile on a worker, inPlace saves only write what changed
+	void StartSave(const std::string& destfile, const std::string& sourcefile, const bool overwrite, const bool inPlace, const bool backup);
+	// Snapshot of the template rows and m_rowinfo for writing, if changes is given it gets the cells edited since the last save
+	std::shared_ptr<const SheetRows> CreateSheetRows(SheetChanges* changes);
+	// Marks all data as saved, called once the loaded file got written successfully
+	void ResetChanges();
+
 	std::string m_filename = "";
 	//										Header									Cell index
 	std::vector<std::pair<std::string, std::pair<int, int>>> m_headerinfo;	// whole information about headers and where they are located
-	int m_headeridx = -1;	// Tells at what row the headers are in m_sheetData
-	std::vector<RowInfo> m_rowinfo;	// Whole generated RowInfo data out of m_sheetData
+	std::vector<std::string> m_headernames;	// Headers of m_headerinfo in the same order
+	int m_headeridx = -1;	// Tells at what row the headers are in the sheet
+	std::vector<RowInfo> m_rowinfo;	// Data rows, the only copy of them once loaded
+	std::shared_ptr<RowLayout> m_layout;	// Layout shared by all loaded rows
+	std::shared_ptr<FileSettings> m_ownedsettings;	// Settings of in memory files like Aggregate results, Settings points to them
+	size_t m_savedrows = 0;	// Rows at the front of m_rowinfo that are still at the same place as in the file
 	bool m_isready = false;	// bool that is set once the file is being loaded correctly
-	std::vector<std::vector<std::string>> m_sheetData;	// loaded sheet
+	std::shared_ptr<const std::vector<std::vector<std::string>>> m_templaterows = std::make_shared<const std::vector<std::vector<std::string>>>();	// Rows up to the header row, written back as they were loaded
+	std::shared_ptr<jobs::JobStatus> m_savejob;	// Last save that was started
+	std::shared_ptr<jobs::JobStatus> m_inplacejob;	// Last save into the loaded file
+	std::unordered_map<std::string, ColumnStats> m_columnstats;	// Cached statistics per header
+	std::map<std::pair<std::string, bool>, SortIndex> m_sortindex;	// Cached sort orders per header and direction
+};
+
+// Distinct values of a column that only has a few of them. Rows store a code into it instead of their own copy,
+// so equal values of the same dictionary can be compared by their code
+class ColumnDictionary {
+public:
+	static constexpr uint32_t NO_CODE = 0xFFFFFFFF;
+
+	// Returns the code of value and adds it if it is not known yet
+	uint32_t Add(const std::string& value);
+	// Returns NO_CODE if value is not part of the dictionary
+	uint32_t Find(const std::string& value) const;
+	const std::string& GetValue(const uint32_t code) const;
+	size_t Size() const;
+
+private:
+	std::deque<std::string> m_values;	// deque keeps the strings in place for the views inside m_codes
+	std::unordered_map<std::string_view, uint32_t> m_codes;
+};
+
+// Bump allocator for the values of a loaded file. Bytes are stored back to back in a few large blocks
+// and are only released together with the arena
+class CellArena {
+public:
+	// Makes sure the next bytes values fit into the current block
+	void Reserve(const size_t bytes);
+	// Copies value into the arena, the view stays valid as long as the arena exists
+	std::string_view Store(const std::string_view value);
+	// Bytes of all stored values
+	size_t Size() const;
+
+private:
+	static constexpr size_t BLOCK_SIZE = 1 << 20;
+
+	std::vector<std::unique_ptr<char[]>> m_blocks;
+	char* m_next = nullptr;
+	size_t m_left = 0;
+	size_t m_size = 0;
+};
+
+// Unique number for a layout whose headers are new or changed, see RowLayout::generation
+uint64_t NewLayoutGeneration();
+
+// Headers, dictionaries and value bytes shared by all rows loaded from the same file
+struct RowLayout {
+	uint64_t generation = NewLayoutGeneration();	// Changes with the headers, so views can keep what they built from them
+	std::vector<std::string> headers;
+	std::vector<std::shared_ptr<const ColumnDictionary>> dictionaries;	// nullptr for columns that are not encoded
+	std::vector<bool> dates;	// Columns that hold dates, their numbers are excel serials
+	std::shared_ptr<CellArena> arena;	// Values that were loaded and are not encoded, nullptr for rows that were built in memory
 };
 
 // RowInfo holds information of one Row inside a sheetData and can be used to access and modify data
 class RowInfo {
 public:
+	RowInfo() = default;
+	// Row with an empty value for every header of layout
+	RowInfo(const std::shared_ptr<RowLayout>& layout);
+
 	// Adds a header with given value
 	void AddData(const std::string& header, const std::string& value);
 	// Updates a value of given Header
 	void UpdateData(const std::string& header, const std::string& newValue);
 	
-	// Get the data of given header
+	// Get the data of given header, numbers and dates are formatted the way they are displayed
 	std::string GetData(const std::string& header) const ;
+	// Typed value of given header, nullptr if the row does not have it
+	const Cell* GetCell(const std::string& header) const;
+	// Number of given header, text is only parsed if it did not get typed as number. Dates are no numbers here
+	bool GetNumber(const std::string& header, double& out) const;
+	// Code of the value of header inside dictionary, NO_CODE if the value is not encoded with that dictionary
+	uint32_t GetCode(const std::string& header, const ColumnDictionary* dictionary) const;
 	// gets all data with header and value as vector
 	std::vector<std::pair<std::string, std::string>> GetData() const;
 	// Completely overwrite the data
@@ -122,12 +272,44 @@ public:
 	bool Changed();
 	// Resets m_changed to false
 	void ResetChanged();
+	// Check if any value was edited since the last save
+	bool IsDirty() const;
+	// Get all values that were edited since the last save
+	std::vector<std::pair<std::string, std::string>> GetDirtyData() const;
+	// Also marks values as edited that differ from previous or were already edited there
+	void MergeDirty(const RowInfo& previous);
+	// Marks all values as saved
+	void ClearDirty();
 	// Unloads all data
 	void Unload();
+	// Sets the value at index x of the layout, values known by the dictionary of the column are stored as code
+	void SetValue(const size_t x, const std::string& value);
+	// Like SetValue but copies values that are not encoded into the arena of the layout, only used when loading
+	void StoreValue(const size_t x, const std::string& value);
+	// Count of values, value x belongs to header x of the layout
+	size_t Size() const;
+	// Formatted value at index x
+	std::string GetValue(const size_t x) const;
+	// Writes the formatted value at index x into out, a buffer that is reused keeps its memory
+	void GetValue(const size_t x, std::string& out) const;
+	const Cell& GetCell(const size_t x) const;
+	// Headers of the values, nullptr if the row is empty
+	const RowLayout* GetLayout() const;
 
 private:
-	//										Header			 Value
-	std::vector<std::pair<std::string, std::string>> m_rowinfo;
+	// Index of header inside this row, -1 if the row does not have it
+	int FindHeader(const std::string& header) const;
+	// Keeps value alive for m_values[x], replacing the previous value owned for x
+	void SetOwnedValue(const size_t x, const std::string& value);
+
+	std::shared_ptr<RowLayout> m_layout;	// Headers of the values, shared with other rows until one of them adds a header
+	// Text of the value, points into the arena or dictionary of the layout or into m_owned.
+	// Numbers and dates do not keep their text if FormatCell gives it back, unless they are encoded
+	std::vector<std::string_view> m_values;
+	std::vector<Cell> m_cells;	// Per value its type and parsed number
+	std::vector<std::pair<size_t, std::shared_ptr<const std::string>>> m_owned;	// Values set after loading by their index, shared by copies of the row
+	std::vector<uint32_t> m_codes;	// Per value its code inside the dictionary of the column or NO_CODE
+	std::vector<bool> m_dirty;	// Per value if it was edited since the last save
 	bool m_changed = false;
 };
 
@@ -138,8 +320,9 @@ class FileSettings {
 public:
 	// Sets the file it is stored in, this is important to set before merging files
 	void SetParentFile(FileInfo* parentFile);
-	void SetMergeFile(const FileInfo otherFile);
-	FileInfo GetMergeFile() const;
+	// Takes over otherFile, pass an rvalue to move it in
+	void SetMergeFile(FileInfo otherFile);
+	const FileInfo& GetMergeFile() const;
 	std::pair<std::string, std::string> GetMergeIf() const;
 	std::vector<std::pair<std::string, std::string>> GetMergeHeaders() const;
 	std::pair<std::string, std::string> GetMergeFolderIf() const;
@@ -153,11 +336,13 @@ public:
 	void MergeFiles();
 	bool IsMergeFileSet() const;
 	void SetMergeFolder(const std::string& folder, const bool ignoreCache = false);
+	// Applies the files that changed inside the merge folder since the last call to the files to merge
+	void UpdateMergeFolder();
 	std::string GetMergeFolder() const;
 	bool IsMergeFolderSet() const;
-	std::unordered_set<std::string> GetMergeFolderPaths() const;
+	const std::unordered_set<std::string>& GetMergeFolderPaths() const;
 	void SetMergeFolderTemplate(const std::string& filepath);
-	FileInfo GetMergeFolderTemplate() const;
+	const FileInfo& GetMergeFolderTemplate() const;
 	bool IsMergeFolderTemplate() const;
 	void Unload();
 	void SetDontImportIf(const std::string& header);
@@ -168,8 +353,11 @@ private:
 	FileInfo m_mergefolderfile;
 	std::string m_dontimportifexistsheader;
 	std::unordered_set<std::string> m_mergefolderpaths;
+	std::unordered_map<std::string, std::string> m_mergefoldercache;	// Merged files and their last write time when merged
+	std::shared_ptr<watcher::Subscription> m_mergefolderwatch;	// Changes inside m_mergefolder
 	std::string m_mergefolder = "";
 	bool m_mergefolderSet = false;
+	bool m_mergefolderignorecache = false;	// Set by SetMergeFolder, every file gets merged no matter what .cache says
 	bool m_mergefolderfileSet = false;
 	bool m_mergefileSet = false;
 	std::vector<std::pair<std::string, std::string>> m_mergeheadersfolder;
@@ -0,0 +1,183 @@
+/*
+MIT License
+
+Copyright (c) 2025 Adrian Jahraus
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "jobs.h"
+
+#include <thread>
+#include <vector>
+#include <deque>
+#include <exception>
+#include "logging.h"
+
+namespace jobs {
+	static std::atomic<uint64_t> s_updates = 0;
+
+	JobStatus::JobStatus(const std::string& name) : m_name(name) {}
+
+	std::string JobStatus::GetName() const {
+		return m_name;
+	}
+
+	JOB_STATE JobStatus::GetState() const {
+		return static_cast<JOB_STATE>(m_state.load());
+	}
+
+	bool JobStatus::IsFinished() const {
+		const JOB_STATE state = GetState();
+		return state == JOB_DONE || state == JOB_FAILED;
+	}
+
+	float JobStatus::GetProgress() const {
+		return m_progress.load();
+	}
+
+	void JobStatus::SetProgress(const float progress) {
+		m_progress = progress < 0.0f ? 0.0f : (progress > 1.0f ? 1.0f : progress);
+		s_updates++;
+	}
+
+	std::string JobStatus::GetStatusText() const {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_text;
+	}
+
+	void JobStatus::SetStatusText(const std::string& text) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_text = text;
+		s_updates++;
+	}
+
+	void JobStatus::Wait() const {
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_finished.wait(lock, [this]() { return IsFinished(); });
+	}
+
+	void JobStatus::Start() {
+		m_state = JOB_RUNNING;
+		s_updates++;
+	}
+
+	void JobStatus::Finish(const bool success) {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (success)
+				m_progress = 1.0f;
+			m_state = success ? JOB_DONE : JOB_FAILED;
+		}
+		s_updates++;
+		m_finished.notify_all();
+	}
+
+	// Worker pool, the threads take jobs in the order they were submitted
+	static std::mutex s_queueMutex;
+	static std::condition_variable s_queueChanged;
+	static std::deque<std::pair<std::shared_ptr<JobStatus>, Job>> s_queue;
+	static std::vector<std::thread> s_workers;
+	static std::vector<std::shared_ptr<JobStatus>> s_listed;
+	static bool s_stopping = false;
+
+	static void s_WorkerLoop() {
+		while (true) {
+			std::pair<std::shared_ptr<JobStatus>, Job> next;
+			{
+				std::unique_lock<std::mutex> lock(s_queueMutex);
+				s_queueChanged.wait(lock, []() { return s_stopping || !s_queue.empty(); });
+				// Queued jobs still run when stopping so no save gets lost
+				if (s_queue.empty())
+					return;
+				next = std::move(s_queue.front());
+				s_queue.pop_front();
+			}
+			JobStatus& status = *next.first;
+			status.Start();
+			bool success = false;
+			try {
+				success = next.second(status);
+			}
+			catch (const std::exception& e) {
+				status.SetStatusText(e.what());
+				logging::logerror("JOBS::%s %s", status.GetName().c_str(), e.what());
+			}
+			catch (...) {
+				status.SetStatusText("Unknown error");
+				logging::logerror("JOBS::%s Unknown error", status.GetName().c_str());
+			}
+			status.Finish(success);
+		}
+	}
+
+	std::shared_ptr<JobStatus> Submit(const std::string& name, Job job, const bool listed) {
+		auto status = std::make_shared<JobStatus>(name);
+		{
+			std::lock_guard<std::mutex> lock(s_queueMutex);
+			if (s_workers.empty()) {
+				// Leave one core for the render thread
+				const unsigned int hw = std::thread::hardware_concurrency();
+				const unsigned int count = hw > 2 ? hw - 1 : 1;
+				s_stopping = false;
+				for (unsigned int i = 0; i < count; i++) {
+					s_workers.emplace_back(s_WorkerLoop);
+				}
+			}
+			s_queue.emplace_back(status, std::move(job));
+			if (listed)
+				s_listed.push_back(status);
+		}
+		s_queueChanged.notify_one();
+		s_updates++;
+		return status;
+	}
+
+	std::vector<std::shared_ptr<JobStatus>> GetJobs() {
+		std::lock_guard<std::mutex> lock(s_queueMutex);
+		return s_listed;
+	}
+
+	void ClearFinishedJobs() {
+		std::lock_guard<std::mutex> lock(s_queueMutex);
+		std::erase_if(s_listed, [](const std::shared_ptr<JobStatus>& job) { return job->IsFinished(); });
+	}
+
+	void Shutdown() {
+		{
+			std::lock_guard<std::mutex> lock(s_queueMutex);
+			s_stopping = true;
+		}
+		s_queueChanged.notify_all();
+		for (auto& worker : s_workers) {
+			if (worker.joinable())
+				worker.join();
+		}
+		s_workers.clear();
+	}
+
+	bool IsStopping() {
+		std::lock_guard<std::mutex> lock(s_queueMutex);
+		return s_stopping;
+	}
+
+	uint64_t GetUpdateCount() {
+		return s_updates.load();
+	}
+};
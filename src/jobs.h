@@ -0,0 +1,91 @@
+/*
+MIT License
+
+Copyright (c) 2025 Adrian Jahraus
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+namespace jobs {
+	enum JOB_STATE {
+		JOB_PENDING,
+		JOB_RUNNING,
+		JOB_DONE,
+		JOB_FAILED
+	};
+
+	// Status of a background job, it is shared between the worker running it and the ui showing it
+	class JobStatus {
+	public:
+		JobStatus(const std::string& name);
+
+		std::string GetName() const;
+		JOB_STATE GetState() const;
+		// Returns true once the job is done or failed
+		bool IsFinished() const;
+		// Progress of the job between 0.0 and 1.0
+		float GetProgress() const;
+		void SetProgress(const float progress);
+		// Text describing what the job is doing, contains the error if it failed
+		std::string GetStatusText() const;
+		void SetStatusText(const std::string& text);
+		// Blocks until the job is finished
+		void Wait() const;
+
+		// Only used by the workers
+		void Start();
+		void Finish(const bool success);
+
+	private:
+		std::string m_name;
+		std::string m_text;
+		std::atomic<int> m_state = JOB_PENDING;
+		std::atomic<float> m_progress = 0.0f;
+		mutable std::mutex m_mutex;
+		mutable std::condition_variable m_finished;
+	};
+
+	// A job reports through its status and returns false if it failed
+	using Job = std::function<bool(JobStatus& status)>;
+
+	// Queues a job for the worker threads, they are started on first use.
+	// Listed jobs are returned by GetJobs() so the ui can show them
+	std::shared_ptr<JobStatus> Submit(const std::string& name, Job job, const bool listed = true);
+	// All listed jobs in the order they were submitted
+	std::vector<std::shared_ptr<JobStatus>> GetJobs();
+	// Removes jobs that are finished from the listed jobs
+	void ClearFinishedJobs();
+	// Runs all queued jobs to the end and stops the workers
+	void Shutdown();
+	// True once Shutdown was called, jobs that are only for speeding things up can skip their work
+	bool IsStopping();
+	// Changes whenever a job is queued, starts, reports progress or finishes, so the ui knows it has to be drawn again
+	uint64_t GetUpdateCount();
+};
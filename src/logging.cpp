@@ -5,7 +5,9 @@
 #include <filesystem>
 #include <string>
 #include <vector>
+#include <mutex>
 
+static std::mutex logMutex;	// Messages can be logged from worker threads
 static std::string lastWarning = "";
 static std::vector<std::string> warnings;
 static std::string lastError = "";
@@ -35,6 +37,7 @@ namespace logging {
 	namespace fs = std::filesystem;
 	
 	void log(const std::string& type, const std::string& msg) {
+		std::lock_guard<std::mutex> lock(logMutex);
 		if (type == "ERROR") {
 			std::cerr << strings::GetTimestamp() << "\t" << type << ":\t" << msg << "\n";
 			lastError = msg;
@@ -98,18 +101,23 @@ namespace logging {
 	}
 
 	std::string GetLastError() {
+		std::lock_guard<std::mutex> lock(logMutex);
 		return lastError;
 	}
 	std::string GetLastWarning() {
+		std::lock_guard<std::mutex> lock(logMutex);
 		return lastWarning;
 	}
 	std::vector<std::string> GetErrors() {
+		std::lock_guard<std::mutex> lock(logMutex);
 		return errors;
 	}
 	std::vector<std::string> GetWarnings() {
+		std::lock_guard<std::mutex> lock(logMutex);
 		return warnings;
 	}
 	std::vector<std::string> GetAllMessages(){
+		std::lock_guard<std::mutex> lock(logMutex);
 		return infos;
 	}
 }
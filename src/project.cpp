@@ -3,6 +3,8 @@
 #include "utils.h"
 #include <filesystem>
 #include <fstream>
+#include <format>
+#include <cstdint>
 
 namespace fs = std::filesystem;
 
@@ -22,12 +24,16 @@ void Project::AddFilePath(const std::string& path){
 			return;
 	m_paths.resize(m_paths.size() + 1);
 	m_paths[m_paths.size() - 1] = path;
+	WatchFiles();
 }
 
 void Project::RemoveFilePath(const std::string& path){
 	if (path == "")
 		return;
 	m_paths.erase(std::find(m_paths.begin(), m_paths.end(), path));
+	std::error_code ec;
+	fs::remove(fs::u8path(GetSnapshotPath(path)), ec);
+	WatchFiles();
 	if (path == m_currentFile) {
 		m_currentFile = "";
 		loadedFile.Unload();
@@ -39,9 +45,15 @@ std::vector<std::string> Project::GetFilePaths() const{
 }
 
 void Project::LoadAllFileData(){
+	for (const std::string& path : m_paths) {
+		LoadFileData(path);
+	}
 }
 
 void Project::LoadFileData(const std::string& path){
+	if (path == "" || path == m_currentFile)
+		return;
+	PrefetchFile(path, GetSnapshotPath(path));
 }
 
 void Project::SelectFile(const std::string& path){
@@ -57,12 +69,71 @@ std::string Project::GetSelectedFile() const {
 	return m_currentFile;
 }
 
+void Project::CheckFileChanges() {
+	for (auto& watch : m_watches) {
+		// Lost events could have been about any of the files
+		const bool overflow = watch->TakeOverflow();
+		const std::vector<fs::path> changes = watch->TakeChanges();
+		if (!overflow && changes.empty())
+			continue;
+		for (const std::string& path : m_paths) {
+			const fs::path filepath = fs::u8path(path);
+			if (filepath.parent_path() != watch->GetDirectory())
+				continue;
+			if (overflow || std::find(changes.begin(), changes.end(), filepath) != changes.end()) {
+				InvalidateCachedFile(path);
+				LoadFileData(path);
+			}
+		}
+	}
+}
+
+void Project::WatchFiles() {
+	std::vector<std::shared_ptr<watcher::Subscription>> watches;
+	for (const std::string& path : m_paths) {
+		const fs::path directory = fs::u8path(path).parent_path();
+		const bool watched = std::any_of(watches.begin(), watches.end(), [&directory](const auto& watch) { return watch->GetDirectory() == directory; });
+		if (watched)
+			continue;
+		// Directories that are already watched keep their subscription and with it the changes not taken yet
+		auto existing = std::find_if(m_watches.begin(), m_watches.end(), [&directory](const auto& watch) { return watch->GetDirectory() == directory; });
+		if (existing != m_watches.end())
+			watches.push_back(*existing);
+		else if (auto watch = watcher::Watch(directory))
+			watches.push_back(watch);
+	}
+	m_watches = std::move(watches);
+}
+
+std::string Project::GetSnapshotPath(const std::string& path) const {
+	// Files of unnamed projects are never stored
+	if (m_name == "" || path == "")
+		return "";
+	// Files with the same name in different folders must not share a snapshot, so the name is made
+	// unique with a hash of the full path. Windows paths are compared without case
+	std::u8string normalized = fs::u8path(path).lexically_normal().generic_u8string();
+#ifdef _WIN32
+	for (char8_t& c : normalized)
+		if (c >= u8'A' && c <= u8'Z')
+			c = c - u8'A' + u8'a';
+#endif
+	uint64_t hash = 14695981039346656037ull;	// FNV-1a, stable across runs unlike std::hash
+	for (const char8_t c : normalized) {
+		hash ^= static_cast<uint8_t>(c);
+		hash *= 1099511628211ull;
+	}
+	const std::u8string name = fs::u8path(path).filename().u8string();
+	const std::string filename(name.begin(), name.end());
+	return std::format("projects/{}/{}_{:016x}.snap", m_name, filename, hash);
+}
+
 void Project::Unload() {
 	if (loadedFile.IsReady())
 		loadedFile.Unload();
 	m_name = "";
 	m_currentFile = "";
 	m_paths.clear();
+	m_watches.clear();
 }
 
 void Project::Load(const std::string& name) {
@@ -102,6 +173,7 @@ void Project::Load(const std::string& name) {
 		}
 	}
 	SelectFile(selectedFile);
+	WatchFiles();
 }
 
 void Project::Save() {
@@ -3,6 +3,7 @@
 #include <string>
 #include <vector>
 #include "fileloader.h"
+#include "watcher.h"
 
 class Project;
 
@@ -15,11 +16,16 @@ public:
 	void RemoveFilePath(const std::string& path);
 	std::vector<std::string> GetFilePaths() const;
 
+	// Parses all project files in the background, so switching to them does not have to parse them
 	void LoadAllFileData();
 	void LoadFileData(const std::string& path);
 
 	void SelectFile(const std::string& path);
 	std::string GetSelectedFile() const;
+	// Path of the parsed data snapshot of a project file
+	std::string GetSnapshotPath(const std::string& path) const;
+	// Drops cached data of project files that changed on disk and loads them again in the background
+	void CheckFileChanges();
 
 	void Unload();
 
@@ -30,8 +36,12 @@ public:
 	FileInfo loadedFile;
 
 private:
+	// Watches the directories of all project files
+	void WatchFiles();
+
 	std::string m_name = "";					// Project name
 	std::string m_currentFile = "";		// To know which file is currently active
 	std::vector<std::string> m_paths;	// All paths added to the project
+	std::vector<std::shared_ptr<watcher::Subscription>> m_watches;	// One per directory of the project files
 };
 
@@ -0,0 +1,303 @@
+/*
+MIT License
+
+Copyright (c) 2025 Adrian Jahraus
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "snapshot.h"
+
+#include <fstream>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include "logging.h"
+#include "timer.h"
+#include "fileloader.h"
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace snapshot {
+	static constexpr char s_magic[8] = { 'N', 'A', 'S', 'N', 'A', 'P', '\0', '\0' };
+	static constexpr uint32_t s_version = 2;	// Increase whenever the layout or the parsing of sheets changes
+	static std::atomic<unsigned int> s_tempCounter = 0;
+
+	struct Header {
+		char magic[8];
+		uint32_t version;
+		uint32_t pathSize;		// Bytes of the utf8 source path following the header
+		uint64_t sourceSize;
+		int64_t sourceTime;		// Last write time of the source
+		uint64_t rows;
+		uint64_t cells;
+		uint64_t dataSize;		// Bytes of all cells together
+	};
+	static_assert(sizeof(Header) == 56, "Snapshot header must not contain padding");
+
+	// Every section starts at a multiple of 8, so the offset tables can be read in place
+	static uint64_t s_Align(const uint64_t size) {
+		return (size + 7) & ~uint64_t(7);
+	}
+
+	// Read only view of a whole file
+	class MappedFile {
+	public:
+		~MappedFile() {
+			Close();
+		}
+		bool Open(const fs::path& path);
+		void Close();
+		const char* Data() const {
+			return m_data;
+		}
+		size_t Size() const {
+			return m_size;
+		}
+
+	private:
+		const char* m_data = nullptr;
+		size_t m_size = 0;
+#ifdef _WIN32
+		HANDLE m_file = INVALID_HANDLE_VALUE;
+		HANDLE m_mapping = nullptr;
+#else
+		int m_file = -1;
+#endif
+	};
+
+#ifdef _WIN32
+	bool MappedFile::Open(const fs::path& path) {
+		Close();
+		m_file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (m_file == INVALID_HANDLE_VALUE)
+			return false;
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(m_file, &size) || size.QuadPart <= 0) {
+			Close();
+			return false;
+		}
+		m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (m_mapping == nullptr) {
+			Close();
+			return false;
+		}
+		m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+		if (m_data == nullptr) {
+			Close();
+			return false;
+		}
+		m_size = static_cast<size_t>(size.QuadPart);
+		return true;
+	}
+
+	void MappedFile::Close() {
+		if (m_data != nullptr)
+			UnmapViewOfFile(m_data);
+		if (m_mapping != nullptr)
+			CloseHandle(m_mapping);
+		if (m_file != INVALID_HANDLE_VALUE)
+			CloseHandle(m_file);
+		m_data = nullptr;
+		m_mapping = nullptr;
+		m_file = INVALID_HANDLE_VALUE;
+		m_size = 0;
+	}
+#else
+	bool MappedFile::Open(const fs::path& path) {
+		Close();
+		m_file = open(path.c_str(), O_RDONLY);
+		if (m_file < 0)
+			return false;
+		struct stat info;
+		if (fstat(m_file, &info) != 0 || info.st_size <= 0) {
+			Close();
+			return false;
+		}
+		void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, m_file, 0);
+		if (data == MAP_FAILED) {
+			Close();
+			return false;
+		}
+		m_data = static_cast<const char*>(data);
+		m_size = static_cast<size_t>(info.st_size);
+		return true;
+	}
+
+	void MappedFile::Close() {
+		if (m_data != nullptr)
+			munmap(const_cast<char*>(m_data), m_size);
+		if (m_file >= 0)
+			close(m_file);
+		m_data = nullptr;
+		m_file = -1;
+		m_size = 0;
+	}
+#endif
+
+	bool GetSourceKey(const fs::path& source, SourceKey& key) {
+		std::error_code ec;
+		key.size = fs::file_size(source, ec);
+		if (ec)
+			return false;
+		const auto writeTime = fs::last_write_time(source, ec);
+		if (ec)
+			return false;
+		key.time = static_cast<int64_t>(writeTime.time_since_epoch().count());
+		return true;
+	}
+
+	bool Write(const fs::path& file, const fs::path& source, const SourceKey& key, const std::vector<std::vector<std::string>>& sheet) {
+		Timer t;
+		t.Start();
+		Header header{};
+		std::memcpy(header.magic, s_magic, sizeof(s_magic));
+		header.version = s_version;
+		header.sourceSize = key.size;
+		header.sourceTime = key.time;
+		const std::u8string sourcePath = source.u8string();
+		header.pathSize = static_cast<uint32_t>(sourcePath.size());
+		header.rows = sheet.size();
+
+		// Offset tables, each one has an extra entry holding the end of the last element
+		std::vector<uint64_t> rowStarts;
+		std::vector<uint64_t> cellOffsets;
+		rowStarts.reserve(sheet.size() + 1);
+		rowStarts.push_back(0);
+		cellOffsets.push_back(0);
+		for (const auto& row : sheet) {
+			for (const auto& cell : row) {
+				header.dataSize += cell.size();
+				cellOffsets.push_back(header.dataSize);
+			}
+			header.cells += row.size();
+			rowStarts.push_back(header.cells);
+		}
+
+		fs::path temp = file;
+		temp += ".writing" + std::to_string(s_tempCounter.fetch_add(1));
+		{
+			std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+			static constexpr char padding[8] = {};
+			out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			out.write(reinterpret_cast<const char*>(sourcePath.data()), sourcePath.size());
+			out.write(padding, s_Align(sourcePath.size()) - sourcePath.size());
+			out.write(reinterpret_cast<const char*>(rowStarts.data()), rowStarts.size() * sizeof(uint64_t));
+			out.write(reinterpret_cast<const char*>(cellOffsets.data()), cellOffsets.size() * sizeof(uint64_t));
+			for (const auto& row : sheet) {
+				for (const auto& cell : row) {
+					out.write(cell.data(), cell.size());
+				}
+			}
+			if (!out) {
+				out.close();
+				std::error_code ec;
+				fs::remove(temp, ec);
+				logging::logwarning("SNAPSHOT::Write Could not write snapshot: %s", file.string().c_str());
+				return false;
+			}
+		}
+		std::error_code ec;
+		fs::rename(temp, file, ec);
+		if (ec) {
+			fs::remove(temp, ec);
+			logging::logwarning("SNAPSHOT::Write Could not replace snapshot: %s", file.string().c_str());
+			return false;
+		}
+		t.Stop();
+		if (IsTimings())
+			logging::loginfo("SNAPSHOT::Write %s took %f ms to write", file.filename().string().c_str(), t.GetElapsedMilliseconds());
+		return true;
+	}
+
+	bool Read(const fs::path& file, const fs::path& source, std::vector<std::vector<std::string>>& sheet) {
+		Timer t;
+		t.Start();
+		MappedFile mapped;
+		if (!mapped.Open(file) || mapped.Size() < sizeof(Header))
+			return false;
+		const char* data = mapped.Data();
+		Header header;
+		std::memcpy(&header, data, sizeof(header));
+		if (std::memcmp(header.magic, s_magic, sizeof(s_magic)) != 0 || header.version != s_version)
+			return false;
+
+		// Only valid as long as the source was not touched since
+		SourceKey key;
+		if (!GetSourceKey(source, key) || header.sourceSize != key.size || header.sourceTime != key.time)
+			return false;
+		const std::u8string sourcePath = source.u8string();
+		if (header.pathSize != sourcePath.size() || sizeof(Header) + header.pathSize > mapped.Size()
+			|| std::memcmp(data + sizeof(Header), sourcePath.data(), sourcePath.size()) != 0)
+			return false;
+
+		// Sizes are checked against the file before any table is used
+		const uint64_t size = mapped.Size();
+		if (header.rows >= size / sizeof(uint64_t) || header.cells >= size / sizeof(uint64_t) || header.dataSize > size)
+			return false;
+		const uint64_t rowsOffset = sizeof(Header) + s_Align(header.pathSize);
+		const uint64_t cellsOffset = rowsOffset + (header.rows + 1) * sizeof(uint64_t);
+		const uint64_t dataOffset = cellsOffset + (header.cells + 1) * sizeof(uint64_t);
+		if (dataOffset + header.dataSize != size) {
+			logging::logwarning("SNAPSHOT::Read Snapshot is corrupted: %s", file.string().c_str());
+			return false;
+		}
+		const uint64_t* rowStarts = reinterpret_cast<const uint64_t*>(data + rowsOffset);
+		const uint64_t* cellOffsets = reinterpret_cast<const uint64_t*>(data + cellsOffset);
+		const char* cells = data + dataOffset;
+		if (rowStarts[0] != 0 || rowStarts[header.rows] != header.cells || cellOffsets[0] != 0 || cellOffsets[header.cells] != header.dataSize) {
+			logging::logwarning("SNAPSHOT::Read Snapshot is corrupted: %s", file.string().c_str());
+			return false;
+		}
+
+		std::vector<std::vector<std::string>> result(header.rows);
+		for (uint64_t row = 0; row < header.rows; row++) {
+			const uint64_t first = rowStarts[row];
+			const uint64_t last = rowStarts[row + 1];
+			if (first > last || last > header.cells) {
+				logging::logwarning("SNAPSHOT::Read Snapshot is corrupted: %s", file.string().c_str());
+				return false;
+			}
+			auto& values = result[row];
+			values.reserve(last - first);
+			for (uint64_t cell = first; cell < last; cell++) {
+				const uint64_t begin = cellOffsets[cell];
+				const uint64_t end = cellOffsets[cell + 1];
+				if (begin > end || end > header.dataSize) {
+					logging::logwarning("SNAPSHOT::Read Snapshot is corrupted: %s", file.string().c_str());
+					return false;
+				}
+				values.emplace_back(cells + begin, end - begin);
+			}
+		}
+		sheet = std::move(result);
+		t.Stop();
+		if (IsTimings())
+			logging::loginfo("SNAPSHOT::Read %s took %f ms to read", file.filename().string().c_str(), t.GetElapsedMilliseconds());
+		return true;
+	}
+}
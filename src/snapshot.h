@@ -0,0 +1,50 @@
+/*
+MIT License
+
+Copyright (c) 2025 Adrian Jahraus
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <cstdint>
+
+// Binary copy of a parsed sheet, so files that did not change since the last session reopen
+// without parsing them again. The file is mapped into memory and its offset tables are used in place,
+// so no text has to be tokenized, but Read() still copies every cell into the sheet it returns.
+// Layout: header, source path, row starts, cell offsets and then all cell bytes back to back.
+// A snapshot is only valid for the source path, size and write time it was created from
+namespace snapshot {
+	// State of a source file a snapshot belongs to
+	struct SourceKey {
+		uint64_t size = 0;
+		int64_t time = 0;	// Last write time
+	};
+
+	// Gets the key of source, it has to be taken before source is parsed
+	bool GetSourceKey(const std::filesystem::path& source, SourceKey& key);
+	// Writes sheet as the snapshot of source with the key it was parsed at, an existing snapshot is replaced atomically
+	bool Write(const std::filesystem::path& file, const std::filesystem::path& source, const SourceKey& key, const std::vector<std::vector<std::string>>& sheet);
+	// Copies the cells of the snapshot into sheet, fails if it is missing, of another version or the source changed since
+	bool Read(const std::filesystem::path& file, const std::filesystem::path& source, std::vector<std::vector<std::string>>& sheet);
+}
@@ -3,48 +3,30 @@
 #include <imgui.h>
 #include <string>
 
+// InputText writes straight into the string, it gets resized whenever the text changes its length
+static int s_ResizeCallback(ImGuiInputTextCallbackData* data) {
+	if (data->EventFlag == ImGuiInputTextFlags_CallbackResize) {
+		std::string* str = static_cast<std::string*>(data->UserData);
+		str->resize(data->BufTextLen);
+		data->Buf = str->data();
+	}
+	return 0;
+}
+
 namespace ImGui {
 bool InputStringWithHint(std::string& str, const std::string& label, const char* hint, ImGuiInputTextFlags flags) {
-	char value_buff[256];
-	char label_buff[256];
-	strncpy_s(value_buff, str.c_str(), 256);
-	strncpy_s(label_buff, label.c_str(), 256);
-	if (InputTextWithHint(label_buff, hint, value_buff, 256, flags)) {
-		str = std::string(value_buff);
-		return true;
-	}
-	return false;
+	return InputStringWithHint(str, label.c_str(), hint, flags);
 }
 
 bool InputStringWithHint(std::string& str, const char* label, const char* hint, ImGuiInputTextFlags flags) {
-	char value_buff[256];
-	strncpy_s(value_buff, str.c_str(), 256);
-	if (InputTextWithHint(label, hint, value_buff, 256, flags)) {
-		str = std::string(value_buff);
-		return true;
-	}
-	return false;
+	return InputTextWithHint(label, hint, str.data(), str.capacity() + 1, flags | ImGuiInputTextFlags_CallbackResize, s_ResizeCallback, &str);
 }
 
 bool InputString(std::string& str, const std::string& label, ImGuiInputTextFlags flags) {
-	char value_buff[256];
-	char label_buff[256];
-	strncpy_s(value_buff, str.c_str(), 256);
-	strncpy_s(label_buff, label.c_str(), 256);
-	if (InputText(label_buff, value_buff, 256, flags)) {
-		str = std::string(value_buff);
-		return true;
-	}
-	return false;
+	return InputString(str, label.c_str(), flags);
 }
 
 bool InputString(std::string& str, const char* label, ImGuiInputTextFlags flags) {
-	char value_buff[256];
-	strncpy_s(value_buff, str.c_str(), 256);
-	if (InputText(label, value_buff, 256, flags)) {
-		str = std::string(value_buff);
-		return true;
-	}
-	return false;
+	return InputText(label, str.data(), str.capacity() + 1, flags | ImGuiInputTextFlags_CallbackResize, s_ResizeCallback, &str);
 }
 };
@@ -1,5 +1,6 @@
 #include "utils.h"
 #include <codecvt>
+#include <charconv>
 #include <Windows.h>
 
 std::string GetLastWriteTime(const std::filesystem::path& path) {
@@ -204,6 +205,53 @@ bool IsInteger(const std::string& input) {
 	return true;
 }
 
+bool StrToNumber(const std::string& input, double& out) {
+	// Copy into a stack buffer to swap the german ',' without allocating
+	char buffer[64];
+	if (input.size() == 0 || input.size() >= sizeof(buffer))
+		return false;
+	size_t start = 0;
+	if (input[0] == '-' || input[0] == '+') {
+		if (input.size() == 1)
+			return false;
+		start = 1;
+	}
+	int dotcount = 0;
+	int digitcount = 0;
+	size_t len = 0;
+	if (input[0] == '-')
+		buffer[len++] = '-';
+	for (size_t i = start; i < input.size(); ++i) {
+		const char c = input[i];
+		if (c >= '0' && c <= '9') {
+			digitcount++;
+			buffer[len++] = c;
+		}
+		else if (c == '.' || c == ',') {
+			if (++dotcount > 1)
+				return false;
+			buffer[len++] = '.';
+		}
+		else {
+			return false;
+		}
+	}
+	if (digitcount == 0)
+		return false;
+	auto result = std::from_chars(buffer, buffer + len, out);
+	return result.ec == std::errc() && result.ptr == buffer + len;
+}
+
+std::string NumberToStr(double value) {
+	char buffer[64];
+	const int len = std::snprintf(buffer, sizeof(buffer), "%.15g", value);
+	if (len <= 0)
+		return "";
+	std::string output(buffer, len);
+	std::replace(output.begin(), output.end(), '.', ',');
+	return output;
+}
+
 std::string ExcelSerialToDate(int serial) {
 	int l = serial + 68569 + 2415019;
 	int n = 4 * l / 146097;
@@ -220,3 +268,27 @@ std::string ExcelSerialToDate(int serial) {
 	oss << std::setfill('0') << std::setw(2) << day << "." << std::setw(2) << month << "." << year;
 	return oss.str();
 }
+
+bool DateToExcelSerial(const std::string& date, int& serial) {
+	// Only accept the exact format ExcelSerialToDate generates (dd.mm.yyyy)
+	if (date.size() != 10 || date[2] != '.' || date[5] != '.')
+		return false;
+	for (size_t i = 0; i < date.size(); i++) {
+		if (i == 2 || i == 5)
+			continue;
+		if (date[i] < '0' || date[i] > '9')
+			return false;
+	}
+	const int day = (date[0] - '0') * 10 + (date[1] - '0');
+	const int month = (date[3] - '0') * 10 + (date[4] - '0');
+	const int year = std::stoi(date.substr(6, 4));
+	if (day < 1 || day > 31 || month < 1 || month > 12)
+		return false;
+	// Inverse of the julian day conversion used in ExcelSerialToDate
+	const int a = (14 - month) / 12;
+	const int y = year + 4800 - a;
+	const int m = month + 12 * a - 3;
+	const int julian = day + (153 * m + 2) / 5 + 365 * y + y / 4 - y / 100 + y / 400 - 32045;
+	serial = julian - 2415019;
+	return true;
+}
@@ -5,6 +5,10 @@
 
 bool IsNumber(const std::string& input);
 bool IsInteger(const std::string& input);
+// Parses a number with either ',' or '.' as decimal separator, returns false if input is not a number
+bool StrToNumber(const std::string& input, double& out);
+// Formats a number the german way with ',' as decimal separator
+std::string NumberToStr(double value);
 
 // Splits a string into 2 parts at given string
 std::pair<std::string, std::string> Splitlines(const std::string& input, const std::string& splitat);
@@ -20,3 +24,5 @@ std::string StrToWstr(const std::string& input);
 std::wstring GetWstring(const std::string& input);
 std::string GetLastWriteTime(const std::filesystem::path& path);
 std::string ExcelSerialToDate(int serial);
+// Converts a date written as dd.mm.yyyy back into an excel serial, returns false if input is no date
+bool DateToExcelSerial(const std::string& date, int& serial);
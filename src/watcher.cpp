@@ -0,0 +1,325 @@
+/*
+MIT License
+
+Copyright (c) 2025 Adrian Jahraus
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "watcher.h"
+
+#include <thread>
+#include <atomic>
+#include "logging.h"
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace watcher {
+	static std::atomic<uint64_t> s_events = 0;
+
+	Subscription::Subscription(const fs::path& directory) : m_directory(directory) {}
+
+	const fs::path& Subscription::GetDirectory() const {
+		return m_directory;
+	}
+
+	std::vector<fs::path> Subscription::TakeChanges() {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		std::vector<fs::path> changes;
+		changes.reserve(m_changes.size());
+		for (const std::string& change : m_changes) {
+			changes.push_back(fs::u8path(change));
+		}
+		m_changes.clear();
+		return changes;
+	}
+
+	bool Subscription::TakeOverflow() {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		const bool overflow = m_overflow;
+		m_overflow = false;
+		return overflow;
+	}
+
+	void Subscription::AddChange(const fs::path& path) {
+		const std::u8string u8path = path.u8string();
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_changes.emplace(u8path.begin(), u8path.end());
+		s_events++;
+	}
+
+	void Subscription::SetOverflow() {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_overflow = true;
+		s_events++;
+	}
+
+	// A directory watched by the operating system and everyone watching it
+	struct WatchedDirectory {
+		fs::path directory;
+		std::vector<std::weak_ptr<Subscription>> subscriptions;
+#ifdef _WIN32
+		HANDLE handle = INVALID_HANDLE_VALUE;
+		OVERLAPPED overlapped{};
+		std::vector<DWORD> buffer;	// Notifications have to be DWORD aligned
+		bool reading = false;
+#else
+		int descriptor = -1;
+#endif
+	};
+
+	static std::mutex s_mutex;
+	static std::vector<std::unique_ptr<WatchedDirectory>> s_directories;	// Only the watcher thread removes directories
+	static std::thread s_thread;
+	static std::atomic<bool> s_stopping = false;
+
+	// Passes a changed file on to everyone still watching its directory, s_mutex has to be locked
+	static void s_Notify(WatchedDirectory& dir, const fs::path& name) {
+		const fs::path path = dir.directory / name;
+		for (auto& weak : dir.subscriptions) {
+			if (auto subscription = weak.lock())
+				subscription->AddChange(path);
+		}
+	}
+
+	static void s_NotifyOverflow(WatchedDirectory& dir) {
+		for (auto& weak : dir.subscriptions) {
+			if (auto subscription = weak.lock())
+				subscription->SetOverflow();
+		}
+	}
+
+#ifdef _WIN32
+	static HANDLE s_wakeEvent = nullptr;
+
+	static bool s_Initialize() {
+		if (s_wakeEvent == nullptr)
+			s_wakeEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+		return s_wakeEvent != nullptr;
+	}
+
+	static void s_Wake() {
+		SetEvent(s_wakeEvent);
+	}
+
+	static bool s_StartWatching(WatchedDirectory& dir) {
+		dir.handle = CreateFileW(dir.directory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+			nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+		if (dir.handle == INVALID_HANDLE_VALUE)
+			return false;
+		dir.overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+		if (dir.overlapped.hEvent == nullptr) {
+			CloseHandle(dir.handle);
+			dir.handle = INVALID_HANDLE_VALUE;
+			return false;
+		}
+		dir.buffer.resize(16 * 1024);
+		return true;
+	}
+
+	static void s_StopWatching(WatchedDirectory& dir) {
+		if (dir.reading) {
+			DWORD bytes = 0;
+			CancelIoEx(dir.handle, &dir.overlapped);
+			GetOverlappedResult(dir.handle, &dir.overlapped, &bytes, TRUE);
+		}
+		if (dir.handle != INVALID_HANDLE_VALUE)
+			CloseHandle(dir.handle);
+		if (dir.overlapped.hEvent != nullptr)
+			CloseHandle(dir.overlapped.hEvent);
+		dir.handle = INVALID_HANDLE_VALUE;
+		dir.overlapped.hEvent = nullptr;
+		dir.reading = false;
+	}
+
+	// Reads are issued by the watcher thread only, windows cancels them once the thread that issued them ends
+	static bool s_Read(WatchedDirectory& dir) {
+		ResetEvent(dir.overlapped.hEvent);
+		return ReadDirectoryChangesW(dir.handle, dir.buffer.data(), static_cast<DWORD>(dir.buffer.size() * sizeof(DWORD)), FALSE,
+			FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE, nullptr, &dir.overlapped, nullptr) != 0;
+	}
+#else
+	static int s_inotify = -1;
+	static constexpr uint32_t s_eventMask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+
+	static bool s_Initialize() {
+		if (s_inotify < 0)
+			s_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		return s_inotify >= 0;
+	}
+
+	static void s_Wake() {
+		// Watches added through inotify are active right away
+	}
+
+	static bool s_StartWatching(WatchedDirectory& dir) {
+		dir.descriptor = inotify_add_watch(s_inotify, dir.directory.c_str(), s_eventMask);
+		return dir.descriptor >= 0;
+	}
+
+	static void s_StopWatching(WatchedDirectory& dir) {
+		if (dir.descriptor >= 0)
+			inotify_rm_watch(s_inotify, dir.descriptor);
+		dir.descriptor = -1;
+	}
+#endif
+
+	// Stops watching directories nobody is interested in anymore, s_mutex has to be locked
+	static void s_RemoveUnused() {
+		std::erase_if(s_directories, [](const std::unique_ptr<WatchedDirectory>& dir) {
+			std::erase_if(dir->subscriptions, [](const std::weak_ptr<Subscription>& weak) { return weak.expired(); });
+			if (!dir->subscriptions.empty())
+				return false;
+			s_StopWatching(*dir);
+			return true;
+		});
+	}
+
+#ifdef _WIN32
+	static void s_ThreadLoop() {
+		while (!s_stopping) {
+			std::vector<HANDLE> events = { s_wakeEvent };
+			std::vector<WatchedDirectory*> waiting;
+			{
+				std::lock_guard<std::mutex> lock(s_mutex);
+				s_RemoveUnused();
+				for (auto& dir : s_directories) {
+					if (!dir->reading)
+						dir->reading = s_Read(*dir);
+					if (dir->reading && events.size() < MAXIMUM_WAIT_OBJECTS) {
+						events.push_back(dir->overlapped.hEvent);
+						waiting.push_back(dir.get());
+					}
+				}
+			}
+			const DWORD result = WaitForMultipleObjects(static_cast<DWORD>(events.size()), events.data(), FALSE, 200);
+			if (result <= WAIT_OBJECT_0 || result >= WAIT_OBJECT_0 + events.size())
+				continue;
+			std::lock_guard<std::mutex> lock(s_mutex);
+			WatchedDirectory& dir = *waiting[result - WAIT_OBJECT_0 - 1];
+			DWORD bytes = 0;
+			dir.reading = false;
+			// No bytes means the buffer was too small for all changes
+			if (!GetOverlappedResult(dir.handle, &dir.overlapped, &bytes, FALSE) || bytes == 0) {
+				s_NotifyOverflow(dir);
+				continue;
+			}
+			const char* data = reinterpret_cast<const char*>(dir.buffer.data());
+			for (DWORD offset = 0; offset < bytes;) {
+				const FILE_NOTIFY_INFORMATION* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(data + offset);
+				s_Notify(dir, fs::path(std::wstring(info->FileName, info->FileNameLength / sizeof(WCHAR))));
+				if (info->NextEntryOffset == 0)
+					break;
+				offset += info->NextEntryOffset;
+			}
+		}
+	}
+#else
+	static void s_ThreadLoop() {
+		alignas(inotify_event) char buffer[16 * 1024];
+		while (!s_stopping) {
+			pollfd descriptor{ s_inotify, POLLIN, 0 };
+			const int ready = poll(&descriptor, 1, 200);
+			std::lock_guard<std::mutex> lock(s_mutex);
+			s_RemoveUnused();
+			if (ready <= 0)
+				continue;
+			const ssize_t size = read(s_inotify, buffer, sizeof(buffer));
+			for (ssize_t offset = 0; offset < size;) {
+				const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+				offset += sizeof(inotify_event) + event->len;
+				for (auto& dir : s_directories) {
+					if (event->mask & IN_Q_OVERFLOW)
+						s_NotifyOverflow(*dir);
+					else if (dir->descriptor != event->wd)
+						continue;
+					else if (event->len > 0)
+						s_Notify(*dir, event->name);
+					// The directory itself got moved or removed
+					else if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF))
+						s_NotifyOverflow(*dir);
+				}
+			}
+		}
+	}
+#endif
+
+	std::shared_ptr<Subscription> Watch(const fs::path& directory) {
+		std::error_code ec;
+		if (directory.empty() || !fs::is_directory(directory, ec))
+			return nullptr;
+		auto subscription = std::make_shared<Subscription>(directory);
+		std::lock_guard<std::mutex> lock(s_mutex);
+		if (s_stopping || !s_Initialize())
+			return nullptr;
+		if (!s_thread.joinable())
+			s_thread = std::thread(s_ThreadLoop);
+		for (auto& dir : s_directories) {
+			if (dir->directory == directory) {
+				dir->subscriptions.push_back(subscription);
+				return subscription;
+			}
+		}
+		auto dir = std::make_unique<WatchedDirectory>();
+		dir->directory = directory;
+		if (!s_StartWatching(*dir)) {
+			logging::logwarning("WATCHER::Watch Could not watch directory: %s", directory.string().c_str());
+			return nullptr;
+		}
+		dir->subscriptions.push_back(subscription);
+		s_directories.push_back(std::move(dir));
+		s_Wake();
+		return subscription;
+	}
+
+	uint64_t GetEventCount() {
+		return s_events.load();
+	}
+
+	void Shutdown() {
+		s_stopping = true;
+#ifdef _WIN32
+		if (s_wakeEvent != nullptr)
+			s_Wake();
+#endif
+		if (s_thread.joinable())
+			s_thread.join();
+		std::lock_guard<std::mutex> lock(s_mutex);
+		for (auto& dir : s_directories) {
+			s_StopWatching(*dir);
+		}
+		s_directories.clear();
+#ifdef _WIN32
+		if (s_wakeEvent != nullptr)
+			CloseHandle(s_wakeEvent);
+		s_wakeEvent = nullptr;
+#else
+		if (s_inotify >= 0)
+			close(s_inotify);
+		s_inotify = -1;
+#endif
+	}
+}
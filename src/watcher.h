@@ -0,0 +1,69 @@
+/*
+MIT License
+
+Copyright (c) 2025 Adrian Jahraus
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <filesystem>
+#include <unordered_set>
+#include <cstdint>
+
+// Watches directories for files that get created, written, renamed or removed. The events are
+// collected on a background thread (inotify on Linux, ReadDirectoryChangesW on Windows) and
+// taken by the watchers whenever they want to, so nothing runs on the thread of the caller.
+// Subdirectories are not watched
+namespace watcher {
+	// Changes of one watched directory since they were taken the last time
+	class Subscription {
+	public:
+		Subscription(const std::filesystem::path& directory);
+
+		const std::filesystem::path& GetDirectory() const;
+		// Every file that changed once, in no particular order
+		std::vector<std::filesystem::path> TakeChanges();
+		// True if events got lost, the whole directory has to be checked again then
+		bool TakeOverflow();
+
+		// Only used by the watcher thread
+		void AddChange(const std::filesystem::path& path);
+		void SetOverflow();
+
+	private:
+		std::filesystem::path m_directory;
+		std::mutex m_mutex;
+		std::unordered_set<std::string> m_changes;	// utf8, so a file that changed often is only returned once
+		bool m_overflow = false;
+	};
+
+	// Starts watching directory until the returned subscription is released.
+	// Returns nullptr if the directory can not be watched
+	std::shared_ptr<Subscription> Watch(const std::filesystem::path& directory);
+	// Changes whenever any watched directory reports a change, so the ui knows it has to check them
+	uint64_t GetEventCount();
+	// Stops the watcher thread, called once when closing
+	void Shutdown();
+}
@@ -0,0 +1,250 @@
+/*
+MIT License
+
+Copyright (c) 2025 Adrian Jahraus
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "xlsxwriter.h"
+
+#include <charconv>
+#include <cctype>
+#include <iterator>
+#include "logging.h"
+#include "utils.h"
+#include "utf8.h"
+
+namespace fs = std::filesystem;
+
+static constexpr size_t s_flushSize = 1 << 16;
+// Column index starting at 0 to the excel column name (0 = A, 26 = AA)
+static void s_AppendColumnName(std::string& out, size_t col) {
+	char name[8];
+	int len = 0;
+	col++;
+	while (col > 0 && len < 8) {
+		col--;
+		name[len++] = static_cast<char>('A' + col % 26);
+		col /= 26;
+	}
+	while (len > 0)
+		out.push_back(name[--len]);
+}
+
+static void s_AppendNumber(std::string& out, const uint64_t value) {
+	char digits[24];
+	auto result = std::to_chars(digits, digits + sizeof(digits), value);
+	out.append(digits, result.ptr);
+}
+
+// Excel does not allow some characters and more than 31 characters in sheet names
+static std::string s_CleanSheetName(const std::string& name) {
+	std::string cleaned;
+	for (const char c : name) {
+		if (c == '[' || c == ']' || c == ':' || c == '*' || c == '?' || c == '/' || c == '\\')
+			continue;
+		cleaned.push_back(c);
+	}
+	if (cleaned.size() > 31)
+		cleaned.resize(31);
+	if (cleaned.empty())
+		cleaned = "Sheet1";
+	return cleaned;
+}
+
+static void s_AppendEscapedXml(std::string& escaped, const std::string& value) {
+	for (const char c : value) {
+		switch (c) {
+		case '&': escaped += "&amp;"; break;
+		case '<': escaped += "&lt;"; break;
+		case '>': escaped += "&gt;"; break;
+		case '"': escaped += "&quot;"; break;
+		default:
+			// Control characters are not allowed inside xml
+			if (static_cast<unsigned char>(c) < 0x20 && c != '\t' && c != '\n' && c != '\r')
+				break;
+			escaped.push_back(c);
+		}
+	}
+}
+
+static std::string s_EscapeXml(const std::string& value) {
+	std::string escaped;
+	escaped.reserve(value.size());
+	s_AppendEscapedXml(escaped, value);
+	return escaped;
+}
+
+static void s_AppendInteger(std::string& out, const int64_t value) {
+	char digits[24];
+	auto result = std::to_chars(digits, digits + sizeof(digits), value);
+	out.append(digits, result.ptr);
+}
+
+// Shortest text that reads back as the same double, always with '.' as excel expects it
+static void s_AppendDouble(std::string& out, const double value) {
+	char digits[32];
+	auto result = std::to_chars(digits, digits + sizeof(digits), value);
+	out.append(digits, result.ptr);
+}
+
+XlsxStreamWriter::XlsxStreamWriter(const fs::path& path, const std::string& sheetname) : m_sheetname(s_CleanSheetName(sheetname)) {
+	m_good = m_zip.Open(path);
+	if (!m_good) {
+		logging::logwarning("XLSXWRITER::XlsxStreamWriter Could not create file: %s", path.string().c_str());
+		return;
+	}
+	m_buffer.reserve(s_flushSize + 4096);
+	m_zip.WriteEntry("[Content_Types].xml",
+		"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+		"<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">"
+		"<Default Extension=\"rels\" ContentType=\"application/vnd.openxmlformats-package.relationships+xml\"/>"
+		"<Default Extension=\"xml\" ContentType=\"application/xml\"/>"
+		"<Override PartName=\"/xl/workbook.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sheet.main+xml\"/>"
+		"<Override PartName=\"/xl/worksheets/sheet1.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.worksheet+xml\"/>"
+		"<Override PartName=\"/xl/styles.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.styles+xml\"/>"
+		"</Types>");
+	m_zip.WriteEntry("_rels/.rels",
+		"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+		"<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+		"<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/officeDocument\" Target=\"xl/workbook.xml\"/>"
+		"</Relationships>");
+	m_zip.WriteEntry("xl/workbook.xml",
+		"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+		"<workbook xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\">"
+		"<sheets><sheet name=\"" + s_EscapeXml(m_sheetname) + "\" sheetId=\"1\" r:id=\"rId1\"/></sheets>"
+		"</workbook>");
+	m_zip.WriteEntry("xl/_rels/workbook.xml.rels",
+		"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+		"<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+		"<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/worksheet\" Target=\"worksheets/sheet1.xml\"/>"
+		"<Relationship Id=\"rId2\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/styles\" Target=\"styles.xml\"/>"
+		"</Relationships>");
+	// Style 1 is the integer format "0", style 2 the text format "@" and style 3 the date format, same as the formats set through xlnt
+	m_zip.WriteEntry("xl/styles.xml",
+		"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+		"<styleSheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\">"
+		"<numFmts count=\"1\"><numFmt numFmtId=\"164\" formatCode=\"dd.mm.yyyy\"/></numFmts>"
+		"<fonts count=\"1\"><font><sz val=\"11\"/><name val=\"Calibri\"/><family val=\"2\"/></font></fonts>"
+		"<fills count=\"2\"><fill><patternFill patternType=\"none\"/></fill><fill><patternFill patternType=\"gray125\"/></fill></fills>"
+		"<borders count=\"1\"><border><left/><right/><top/><bottom/><diagonal/></border></borders>"
+		"<cellStyleXfs count=\"1\"><xf numFmtId=\"0\" fontId=\"0\" fillId=\"0\" borderId=\"0\"/></cellStyleXfs>"
+		"<cellXfs count=\"4\">"
+		"<xf numFmtId=\"0\" fontId=\"0\" fillId=\"0\" borderId=\"0\" xfId=\"0\"/>"
+		"<xf numFmtId=\"1\" fontId=\"0\" fillId=\"0\" borderId=\"0\" xfId=\"0\" applyNumberFormat=\"1\"/>"
+		"<xf numFmtId=\"49\" fontId=\"0\" fillId=\"0\" borderId=\"0\" xfId=\"0\" applyNumberFormat=\"1\"/>"
+		"<xf numFmtId=\"164\" fontId=\"0\" fillId=\"0\" borderId=\"0\" xfId=\"0\" applyNumberFormat=\"1\"/>"
+		"</cellXfs>"
+		"<cellStyles count=\"1\"><cellStyle name=\"Normal\" xfId=\"0\" builtinId=\"0\"/></cellStyles>"
+		"</styleSheet>");
+	// The worksheet stays open until Close(), rows are appended to it
+	m_zip.BeginEntry("xl/worksheets/sheet1.xml", true);
+	m_buffer += "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+		"<worksheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\"><sheetData>";
+}
+
+XlsxStreamWriter::~XlsxStreamWriter() {
+	if (!m_closed)
+		Close();
+}
+
+bool XlsxStreamWriter::IsGood() const {
+	return m_good;
+}
+
+void XlsxStreamWriter::WriteRow(const std::vector<std::string>& row, const std::vector<Cell>& cells) {
+	if (!m_good || m_closed)
+		return;
+	m_row++;
+	m_buffer += "<row r=\"";
+	s_AppendNumber(m_buffer, m_row);
+	m_buffer += "\">";
+	for (size_t col = 0; col < row.size(); col++) {
+		const std::string& value = row[col];
+		if (value.empty())
+			continue;
+		const Cell& cell = col < cells.size() ? cells[col] : Cell();
+		m_buffer += "<c r=\"";
+		s_AppendColumnName(m_buffer, col);
+		s_AppendNumber(m_buffer, m_row);
+		switch (cell.type) {
+		case CELL_FORMULA:
+			m_buffer += "\"><f>";
+			WriteEscaped(value.substr(1));
+			m_buffer += "</f></c>";
+			continue;
+		case CELL_INTEGER:
+			m_buffer += "\" s=\"1\"><v>";
+			s_AppendInteger(m_buffer, cell.integer);
+			m_buffer += "</v></c>";
+			continue;
+		case CELL_NUMBER:
+			m_buffer += "\"><v>";
+			s_AppendDouble(m_buffer, cell.number);
+			m_buffer += "</v></c>";
+			continue;
+		case CELL_DATE:
+			m_buffer += "\" s=\"3\"><v>";
+			s_AppendDouble(m_buffer, cell.number);
+			m_buffer += "</v></c>";
+			continue;
+		default:
+			break;
+		}
+		// Text is written inline, so no string has to be kept until Close()
+		const bool preserve = std::isspace(static_cast<unsigned char>(value.front())) || std::isspace(static_cast<unsigned char>(value.back()));
+		m_buffer += preserve ? "\" s=\"2\" t=\"inlineStr\"><is><t xml:space=\"preserve\">" : "\" s=\"2\" t=\"inlineStr\"><is><t>";
+		if (!IsValidUTF8(value)) {
+			std::string text;
+			utf8::replace_invalid(value.begin(), value.end(), std::back_inserter(text));
+			WriteEscaped(text);
+		}
+		else
+			WriteEscaped(value);
+		m_buffer += "</t></is></c>";
+	}
+	m_buffer += "</row>";
+	if (m_buffer.size() >= s_flushSize)
+		Flush();
+}
+
+bool XlsxStreamWriter::Close() {
+	if (m_closed)
+		return m_good;
+	m_closed = true;
+	if (!m_good)
+		return false;
+	m_buffer += "</sheetData></worksheet>";
+	Flush();
+	m_zip.EndEntry();
+	m_good = m_zip.Close() && m_good;
+	return m_good;
+}
+
+void XlsxStreamWriter::WriteEscaped(const std::string& value) {
+	s_AppendEscapedXml(m_buffer, value);
+}
+
+void XlsxStreamWriter::Flush() {
+	m_zip.Write(m_buffer.data(), m_buffer.size());
+	m_buffer.clear();
+	if (!m_zip.IsGood())
+		m_good = false;
+}
@@ -0,0 +1,62 @@
+/*
+MIT License
+
+Copyright (c) 2025 Adrian Jahraus
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <cstdint>
+#include "zip.h"
+#include "cell.h"
+
+// Forward only writer for .xlsx files with a single worksheet and no template.
+// Rows are deflated straight into the zip file and text is written inline, so memory
+// stays the same no matter how many rows get written
+class XlsxStreamWriter {
+public:
+	XlsxStreamWriter(const std::filesystem::path& path, const std::string& sheetname = "Sheet1");
+	~XlsxStreamWriter();
+
+	// Returns false if the file could not be created or a write failed
+	bool IsGood() const;
+	// Writes the next row, cells holds the type of every value like the cells written with xlnt:
+	// formulas, integers, numbers and dates keep their type and everything else becomes text
+	void WriteRow(const std::vector<std::string>& row, const std::vector<Cell>& cells);
+	// Finishes the worksheet and writes the zip directory
+	bool Close();
+
+private:
+	void WriteEscaped(const std::string& value);
+	// Moves the buffered xml into the current zip entry
+	void Flush();
+
+	ZipWriter m_zip;
+	std::string m_buffer;
+	bool m_good = false;
+	bool m_closed = false;
+
+	std::string m_sheetname;
+	uint32_t m_row = 0;	// Rows written so far
+};
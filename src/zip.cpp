@@ -0,0 +1,378 @@
+/*
+MIT License
+
+Copyright (c) 2025 Adrian Jahraus
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "zip.h"
+
+#include <array>
+#include <algorithm>
+#include <ctime>
+#include <miniz.h>
+#include "logging.h"
+
+namespace fs = std::filesystem;
+
+static constexpr uint32_t s_maxEntrySize = 0xFFFFFFFFu;
+
+static const std::array<uint32_t, 256>& s_CrcTable() {
+	static const std::array<uint32_t, 256> table = []() {
+		std::array<uint32_t, 256> t{};
+		for (uint32_t i = 0; i < 256; i++) {
+			uint32_t c = i;
+			for (int k = 0; k < 8; k++)
+				c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			t[i] = c;
+		}
+		return t;
+	}();
+	return table;
+}
+
+uint32_t ZipCrc32(uint32_t crc, const char* data, const size_t size) {
+	const auto& table = s_CrcTable();
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++)
+		crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
+
+static void s_Put16(std::string& out, const uint16_t value) {
+	out.push_back(static_cast<char>(value & 0xFF));
+	out.push_back(static_cast<char>((value >> 8) & 0xFF));
+}
+
+static void s_Put32(std::string& out, const uint32_t value) {
+	s_Put16(out, static_cast<uint16_t>(value & 0xFFFF));
+	s_Put16(out, static_cast<uint16_t>(value >> 16));
+}
+
+static uint16_t s_Get16(const char* data) {
+	return static_cast<uint16_t>(static_cast<uint8_t>(data[0]) | (static_cast<uint8_t>(data[1]) << 8));
+}
+
+static uint32_t s_Get32(const char* data) {
+	return static_cast<uint32_t>(s_Get16(data)) | (static_cast<uint32_t>(s_Get16(data + 2)) << 16);
+}
+
+bool ZipReader::Open(const fs::path& path) {
+	m_entries.clear();
+	m_index.clear();
+	m_file.open(path, std::ios::binary);
+	if (!m_file)
+		return false;
+	// The end of central directory record is at the end, behind an optional comment
+	m_file.seekg(0, std::ios::end);
+	const int64_t fileSize = static_cast<int64_t>(m_file.tellg());
+	const int64_t tailSize = std::min<int64_t>(fileSize, 0xFFFF + 22);
+	std::string tail(static_cast<size_t>(tailSize), '\0');
+	m_file.seekg(fileSize - tailSize);
+	m_file.read(tail.data(), tailSize);
+	if (!m_file || tailSize < 22)
+		return false;
+	int64_t eocd = -1;
+	for (int64_t i = tailSize - 22; i >= 0; i--) {
+		if (s_Get32(tail.data() + i) == 0x06054b50) {
+			eocd = i;
+			break;
+		}
+	}
+	if (eocd < 0)
+		return false;
+	const uint16_t count = s_Get16(tail.data() + eocd + 10);
+	const uint32_t directorySize = s_Get32(tail.data() + eocd + 12);
+	const uint32_t directoryOffset = s_Get32(tail.data() + eocd + 16);
+	if (count == 0xFFFF || directoryOffset == 0xFFFFFFFFu || static_cast<int64_t>(directoryOffset) + directorySize > fileSize)
+		return false;	// zip64
+	std::string directory(directorySize, '\0');
+	m_file.seekg(directoryOffset);
+	m_file.read(directory.data(), directorySize);
+	if (!m_file)
+		return false;
+	size_t pos = 0;
+	for (uint16_t i = 0; i < count; i++) {
+		if (pos + 46 > directory.size() || s_Get32(directory.data() + pos) != 0x02014b50)
+			return false;
+		const char* header = directory.data() + pos;
+		ZipEntryInfo entry;
+		entry.method = s_Get16(header + 10);
+		entry.crc = s_Get32(header + 16);
+		entry.compressedSize = s_Get32(header + 20);
+		entry.size = s_Get32(header + 24);
+		const uint16_t nameLength = s_Get16(header + 28);
+		const uint16_t extraLength = s_Get16(header + 30);
+		const uint16_t commentLength = s_Get16(header + 32);
+		entry.offset = s_Get32(header + 42);
+		if (pos + 46 + nameLength > directory.size())
+			return false;
+		if (entry.compressedSize == 0xFFFFFFFFu || entry.size == 0xFFFFFFFFu || entry.offset == 0xFFFFFFFFu)
+			return false;	// zip64
+		entry.name.assign(header + 46, nameLength);
+		m_index[entry.name] = m_entries.size();
+		m_entries.push_back(std::move(entry));
+		pos += 46 + nameLength + extraLength + commentLength;
+	}
+	return true;
+}
+
+const ZipEntryInfo* ZipReader::Find(const std::string& name) const {
+	auto it = m_index.find(name);
+	if (it == m_index.end())
+		return nullptr;
+	return &m_entries[it->second];
+}
+
+bool ZipReader::ReadRaw(const ZipEntryInfo& entry, std::string& out) {
+	// The local header can have another extra field than the central directory
+	char header[30];
+	m_file.clear();
+	m_file.seekg(entry.offset);
+	m_file.read(header, sizeof(header));
+	if (!m_file || s_Get32(header) != 0x04034b50)
+		return false;
+	const uint32_t dataStart = entry.offset + 30 + s_Get16(header + 26) + s_Get16(header + 28);
+	out.resize(entry.compressedSize);
+	m_file.seekg(dataStart);
+	m_file.read(out.data(), entry.compressedSize);
+	return static_cast<bool>(m_file);
+}
+
+bool ZipReader::Read(const std::string& name, std::string& out) {
+	const ZipEntryInfo* entry = Find(name);
+	if (!entry)
+		return false;
+	std::string raw;
+	if (!ReadRaw(*entry, raw))
+		return false;
+	return Decompress(*entry, raw, out);
+}
+
+bool ZipReader::Decompress(const ZipEntryInfo& entry, const std::string& raw, std::string& out) {
+	if (entry.method == 0)
+		out = raw;
+	else if (entry.method == 8) {
+		// Raw deflate data without a zlib header, the entry size bounds the output so broken data can not grow it
+		out.resize(entry.size);
+		const size_t size = tinfl_decompress_mem_to_mem(out.data(), out.size(), raw.data(), raw.size(), 0);
+		if (size == TINFL_DECOMPRESS_MEM_TO_MEM_FAILED)
+			return false;
+		out.resize(size);
+	}
+	else
+		return false;
+	return out.size() == entry.size && ZipCrc32(0, out.data(), out.size()) == entry.crc;
+}
+
+// The compressor writes its output straight into the package and counts it
+struct ZipDeflater {
+	tdefl_compressor compressor;
+	std::ofstream* file = nullptr;
+	uint64_t written = 0;
+};
+
+static mz_bool s_PutDeflated(const void* data, int len, void* user) {
+	ZipDeflater* deflater = static_cast<ZipDeflater*>(user);
+	deflater->file->write(static_cast<const char*>(data), len);
+	deflater->written += static_cast<uint64_t>(len);
+	return deflater->file->good();
+}
+
+ZipWriter::ZipWriter() = default;
+
+ZipWriter::~ZipWriter() {
+	if (!m_closed && m_file.is_open())
+		Close();
+}
+
+bool ZipWriter::Open(const fs::path& path) {
+	m_file.open(path, std::ios::binary | std::ios::trunc);
+	m_good = m_file.is_open();
+	if (!m_good)
+		return false;
+	// Entries store the time in dos format
+	const std::time_t now = std::time(nullptr);
+	std::tm local{};
+#ifdef _MSC_VER
+	localtime_s(&local, &now);
+#else
+	localtime_r(&now, &local);
+#endif
+	m_dosTime = static_cast<uint16_t>((local.tm_hour << 11) | (local.tm_min << 5) | (local.tm_sec / 2));
+	m_dosDate = static_cast<uint16_t>(((local.tm_year - 80) << 9) | ((local.tm_mon + 1) << 5) | local.tm_mday);
+	return true;
+}
+
+bool ZipWriter::IsGood() const {
+	return m_good;
+}
+
+void ZipWriter::WriteLocalHeader(const ZipEntryInfo& entry) {
+	std::string header;
+	s_Put32(header, 0x04034b50);	// local file header signature
+	s_Put16(header, 20);	// version needed to extract
+	s_Put16(header, 0);	// flags
+	s_Put16(header, entry.method);
+	s_Put16(header, m_dosTime);
+	s_Put16(header, m_dosDate);
+	s_Put32(header, entry.crc);
+	s_Put32(header, entry.compressedSize);
+	s_Put32(header, entry.size);
+	s_Put16(header, static_cast<uint16_t>(entry.name.size()));
+	s_Put16(header, 0);	// extra field length
+	header += entry.name;
+	m_file.write(header.data(), header.size());
+}
+
+void ZipWriter::BeginEntry(const std::string& name, const bool deflate) {
+	if (m_entryOpen)
+		EndEntry();
+	ZipEntryInfo entry;
+	entry.name = name;
+	entry.method = deflate ? 8 : 0;
+	entry.offset = static_cast<uint32_t>(m_file.tellp());
+	WriteLocalHeader(entry);
+	m_entries.push_back(entry);
+	m_entryOpen = true;
+	if (!deflate)
+		return;
+	// Raw deflate without zlib header, like zip expects it
+	if (!m_deflater)
+		m_deflater = std::make_unique<ZipDeflater>();
+	m_deflater->file = &m_file;
+	m_deflater->written = 0;
+	const mz_uint flags = tdefl_create_comp_flags_from_zip_params(MZ_DEFAULT_LEVEL, -MZ_DEFAULT_WINDOW_BITS, MZ_DEFAULT_STRATEGY);
+	if (tdefl_init(&m_deflater->compressor, s_PutDeflated, m_deflater.get(), static_cast<int>(flags)) != TDEFL_STATUS_OKAY)
+		m_good = false;
+}
+
+void ZipWriter::Write(const char* data, const size_t size) {
+	if (!m_entryOpen || size == 0)
+		return;
+	ZipEntryInfo& entry = m_entries.back();
+	if (static_cast<uint64_t>(entry.size) + size > s_maxEntrySize) {
+		logging::logerror("ZIP::ZipWriter::Write %s is too large for a zip file without zip64", entry.name.c_str());
+		m_good = false;
+		return;
+	}
+	entry.crc = ZipCrc32(entry.crc, data, size);
+	entry.size += static_cast<uint32_t>(size);
+	if (entry.method == 8) {
+		if (tdefl_compress_buffer(&m_deflater->compressor, data, size, TDEFL_NO_FLUSH) != TDEFL_STATUS_OKAY)
+			m_good = false;
+		return;
+	}
+	entry.compressedSize = entry.size;
+	m_file.write(data, size);
+	if (!m_file)
+		m_good = false;
+}
+
+void ZipWriter::EndEntry() {
+	if (!m_entryOpen)
+		return;
+	m_entryOpen = false;
+	ZipEntryInfo& entry = m_entries.back();
+	if (entry.method == 8) {
+		// Whatever the compressor still holds gets written with the final block
+		if (tdefl_compress_buffer(&m_deflater->compressor, nullptr, 0, TDEFL_FINISH) != TDEFL_STATUS_DONE)
+			m_good = false;
+		if (m_deflater->written > s_maxEntrySize) {
+			logging::logerror("ZIP::ZipWriter::EndEntry %s is too large for a zip file without zip64", entry.name.c_str());
+			m_good = false;
+		}
+		entry.compressedSize = static_cast<uint32_t>(m_deflater->written);
+	}
+	// Patch crc and sizes into the local header, the file is seekable so no data descriptor is needed
+	const std::streampos end = m_file.tellp();
+	std::string sizes;
+	s_Put32(sizes, entry.crc);
+	s_Put32(sizes, entry.compressedSize);
+	s_Put32(sizes, entry.size);
+	m_file.seekp(static_cast<std::streamoff>(entry.offset) + 14);
+	m_file.write(sizes.data(), sizes.size());
+	m_file.seekp(end);
+	if (!m_file)
+		m_good = false;
+}
+
+void ZipWriter::WriteEntry(const std::string& name, const std::string& content, const bool deflate) {
+	BeginEntry(name, deflate);
+	Write(content.data(), content.size());
+	EndEntry();
+}
+
+void ZipWriter::WriteRawEntry(const std::string& name, const ZipEntryInfo& source, const std::string& raw) {
+	if (m_entryOpen)
+		EndEntry();
+	ZipEntryInfo entry = source;
+	entry.name = name;
+	entry.offset = static_cast<uint32_t>(m_file.tellp());
+	WriteLocalHeader(entry);
+	m_file.write(raw.data(), raw.size());
+	m_entries.push_back(entry);
+	if (!m_file)
+		m_good = false;
+}
+
+bool ZipWriter::Close() {
+	if (m_closed)
+		return m_good;
+	m_closed = true;
+	if (m_entryOpen)
+		EndEntry();
+	const uint32_t start = static_cast<uint32_t>(m_file.tellp());
+	std::string directory;
+	for (const ZipEntryInfo& entry : m_entries) {
+		s_Put32(directory, 0x02014b50);	// central file header signature
+		s_Put16(directory, 20);	// version made by
+		s_Put16(directory, 20);	// version needed to extract
+		s_Put16(directory, 0);	// flags
+		s_Put16(directory, entry.method);
+		s_Put16(directory, m_dosTime);
+		s_Put16(directory, m_dosDate);
+		s_Put32(directory, entry.crc);
+		s_Put32(directory, entry.compressedSize);
+		s_Put32(directory, entry.size);
+		s_Put16(directory, static_cast<uint16_t>(entry.name.size()));
+		s_Put16(directory, 0);	// extra field length
+		s_Put16(directory, 0);	// comment length
+		s_Put16(directory, 0);	// disk number
+		s_Put16(directory, 0);	// internal attributes
+		s_Put32(directory, 0);	// external attributes
+		s_Put32(directory, entry.offset);
+		directory += entry.name;
+	}
+	const uint32_t size = static_cast<uint32_t>(directory.size());
+	s_Put32(directory, 0x06054b50);	// end of central directory signature
+	s_Put16(directory, 0);	// number of this disk
+	s_Put16(directory, 0);	// disk with the central directory
+	s_Put16(directory, static_cast<uint16_t>(m_entries.size()));
+	s_Put16(directory, static_cast<uint16_t>(m_entries.size()));
+	s_Put32(directory, size);
+	s_Put32(directory, start);
+	s_Put16(directory, 0);	// comment length
+	m_file.write(directory.data(), directory.size());
+	m_file.close();
+	if (!m_file)
+		m_good = false;
+	return m_good;
+}
@@ -0,0 +1,105 @@
+/*
+MIT License
+
+Copyright (c) 2025 Adrian Jahraus
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+#include <unordered_map>
+#include <memory>
+#include <cstdint>
+
+// Minimal zip support for xlsx packages. Entries can be written stored, deflated with the miniz that
+// comes with xlnt or copied from another package as they are, so already deflated parts never get
+// decompressed and compressed again. Reading inflates with miniz aswell.
+// Zip64 is not supported, packages with it fail to open
+
+// One entry of the central directory
+struct ZipEntryInfo {
+	std::string name;
+	uint16_t method = 0;	// 0 = stored, 8 = deflated
+	uint32_t crc = 0;
+	uint32_t compressedSize = 0;
+	uint32_t size = 0;
+	uint32_t offset = 0;	// Offset of the local header inside the package
+};
+
+// Updates a crc32 with the given data, start with crc = 0
+uint32_t ZipCrc32(uint32_t crc, const char* data, const size_t size);
+
+class ZipReader {
+public:
+	// Reads the central directory of the package
+	bool Open(const std::filesystem::path& path);
+	// Returns nullptr if there is no entry with that name
+	const ZipEntryInfo* Find(const std::string& name) const;
+	// Reads the data of an entry as it is stored inside the package
+	bool ReadRaw(const ZipEntryInfo& entry, std::string& out);
+	// Reads and decompresses an entry
+	bool Read(const std::string& name, std::string& out);
+	// Decompresses the raw data of an entry and checks it against its crc
+	static bool Decompress(const ZipEntryInfo& entry, const std::string& raw, std::string& out);
+
+private:
+	std::ifstream m_file;
+	std::vector<ZipEntryInfo> m_entries;
+	std::unordered_map<std::string, size_t> m_index;	// Entry name to index inside m_entries
+};
+
+// Deflate stream of the entry that is written right now
+struct ZipDeflater;
+
+class ZipWriter {
+public:
+	ZipWriter();
+	~ZipWriter();
+	bool Open(const std::filesystem::path& path);
+	// Returns false if the file could not be created or a write failed
+	bool IsGood() const;
+	// Starts an entry whose data is written in pieces, its header gets patched in EndEntry().
+	// Deflated entries are compressed while they are written, so only the compressed data reaches the file
+	void BeginEntry(const std::string& name, const bool deflate = false);
+	void Write(const char* data, const size_t size);
+	void EndEntry();
+	// Writes a complete entry
+	void WriteEntry(const std::string& name, const std::string& content, const bool deflate = false);
+	// Writes an entry of another package with its data as it was stored there
+	void WriteRawEntry(const std::string& name, const ZipEntryInfo& source, const std::string& raw);
+	// Writes the central directory and closes the file
+	bool Close();
+
+private:
+	void WriteLocalHeader(const ZipEntryInfo& entry);
+
+	std::ofstream m_file;
+	std::vector<ZipEntryInfo> m_entries;
+	std::unique_ptr<ZipDeflater> m_deflater;	// Only allocated once the first deflated entry gets written
+	bool m_entryOpen = false;
+	bool m_good = false;
+	bool m_closed = false;
+	uint16_t m_dosTime = 0;
+	uint16_t m_dosDate = 0;
+};